@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    GoldenCompat.h
+    Created: 17 Oct 2026 1:42:10pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/**
+ The parts of sketchbook::OfflineRenderer that GoldenRender uses, written only
+ against the engine api every commit has had: a default constructed engine,
+ prepare(sampleRate, blockSize) and process. This lets the golden renders be
+ made with the engine from before the offline renderer existed, see golden.sh.
+ 
+ The blocks are split exactly as OfflineRenderer::renderToBuffer splits them,
+ so a render from here nulls against one from the benchmarks executable.
+ */
+namespace GoldenCompat
+{
+
+struct RenderSettings
+{
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int numChannels = 2;
+    
+    /** unused, the voices are always rendered on the calling thread */
+    int numRenderThreads = 1;
+};
+
+namespace OfflineRender
+{
+    inline juce::Result writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate, int bitDepth)
+    {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        
+        if (stream->failedToOpen())
+            return juce::Result::fail("could not open " + file.getFullPathName() + " for writing");
+        
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate, (unsigned int) audio.getNumChannels(),
+                                                                               bitDepth, {}, 0));
+        
+        if (writer == nullptr)
+            return juce::Result::fail("could not write a " + juce::String(bitDepth) + " bit wav file");
+        
+        //the writer owns the stream from here
+        stream.release();
+        
+        if (!writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples()))
+            return juce::Result::fail("could not write to " + file.getFullPathName());
+        
+        return juce::Result::ok();
+    }
+    
+    inline juce::Result readWavFile(const juce::File& file, juce::AudioBuffer<float>& dest, double& sampleRate)
+    {
+        auto stream = file.createInputStream();
+        
+        if (stream == nullptr)
+            return juce::Result::fail("could not open " + file.getFullPathName());
+        
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatReader> reader(format.createReaderFor(stream.release(), true));
+        
+        if (reader == nullptr)
+            return juce::Result::fail("could not read a wav file from " + file.getFullPathName());
+        
+        dest.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+        sampleRate = reader->sampleRate;
+        
+        if (!reader->read(&dest, 0, dest.getNumSamples(), 0, true, true))
+            return juce::Result::fail("could not read " + file.getFullPathName());
+        
+        return juce::Result::ok();
+    }
+}
+
+//==============================================================================
+template <typename EngineType>
+class OfflineRenderer
+{
+    public:
+    
+    explicit OfflineRenderer(RenderSettings renderSettings = {})
+        : settings(renderSettings)
+    {
+    }
+    
+    /** renders with the engine's default state, returns the time spent processing in seconds */
+    double renderToBuffer(const juce::MidiBuffer& midi, int numSamples, const juce::ValueTree& state, juce::AudioBuffer<float>& dest) const
+    {
+        //saved states are not supported, the golden renders never use one
+        jassert(!state.isValid());
+        juce::ignoreUnused(state);
+        
+        //engines hold all of their voices, too much for the stack
+        auto engine = std::make_unique<EngineType>();
+        engine->prepare(float(settings.sampleRate), settings.blockSize);
+        
+        dest.setSize(settings.numChannels, numSamples);
+        dest.clear();
+        
+        juce::MidiBuffer blockMidi;
+        blockMidi.ensureSize((size_t) midi.data.size());
+        
+        const double startTime = juce::Time::getMillisecondCounterHiRes();
+        
+        for (int start = 0; start < numSamples; start += settings.blockSize)
+        {
+            const int blockLength = juce::jmin(settings.blockSize, numSamples - start);
+            
+            juce::AudioBuffer<float> block(dest.getArrayOfWritePointers(), settings.numChannels, start, blockLength);
+            
+            blockMidi.clear();
+            blockMidi.addEvents(midi, start, blockLength, -start);
+            
+            engine->process(block, blockMidi, 0, blockLength);
+        }
+        
+        return (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    }
+    
+    private:
+    
+    RenderSettings settings;
+};
+    
+} //end namespace GoldenCompat
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    GoldenMain.cpp
+    Created: 17 Oct 2026 1:42:10pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "GoldenRender.h"
+
+//only the golden renders, the rest of the benchmarks need the current engine
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+    
+    if (!GoldenRender::isRequested(args))
+    {
+        std::cout << "usage: Sketchbook_Golden --golden-record=<folder> | --golden-check=<folder> [options]" << std::endl
+                  << "see Source/GoldenRender.h for the options" << std::endl;
+        return 1;
+    }
+    
+    return GoldenRender::run(args);
+}
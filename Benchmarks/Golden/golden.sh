@@ -0,0 +1,150 @@
+#!/usr/bin/env bash
+#records the golden references from the baseline engine, and checks every later
+#commit against them, see README.md
+#
+#   golden.sh record [<commit>]             records into Benchmarks/Golden, from the root commit by default
+#   golden.sh check [<first> [<last>]]      checks each commit after <first> up to <last>, HEAD by default
+#
+#GOLDEN_WORK_DIR keeps the builds between runs, CMAKE_GENERATOR and the usual cmake
+#variables are passed through
+
+set -euo pipefail
+
+golden_dir="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+repo_dir="$(git -C "$golden_dir" rev-parse --show-toplevel)"
+sound_changes="$golden_dir/sound_changes.txt"
+
+work_dir="${GOLDEN_WORK_DIR:-$(mktemp -d)}"
+module_parent="$work_dir/module"
+build_dir="$work_dir/build"
+
+usage()
+{
+    sed -n '5,6p' "${BASH_SOURCE[0]}" | sed 's/^#//'
+    exit 1
+}
+
+root_commit()
+{
+    git -C "$repo_dir" rev-list --max-parents=0 HEAD | tail -n 1
+}
+
+#builds Sketchbook_Golden against the module of the given commit, warnings are errors
+build()
+{
+    local commit="$1"
+
+    rm -rf "$module_parent"
+    mkdir -p "$module_parent"
+    git -C "$repo_dir" archive "$commit" DSP_Sketchbook | tar -x -C "$module_parent" || return 1
+
+    cmake -S "$golden_dir/Compat" -B "$build_dir" -DCMAKE_BUILD_TYPE=Release \
+          -DSKETCHBOOK_MODULE_DIR="$module_parent/DSP_Sketchbook" \
+          -DSKETCHBOOK_JUCE_DIR="$repo_dir/Submodules/JUCE" \
+          -DSKETCHBOOK_WARNINGS_AS_ERRORS=ON > /dev/null || return 1
+
+    cmake --build "$build_dir" --config Release -j"$(nproc 2>/dev/null || echo 4)" > "$work_dir/build.log" 2>&1 \
+        || { tail -n 40 "$work_dir/build.log" >&2; return 1; }
+
+    find "$build_dir" -type f -name Sketchbook_Golden -perm -u+x | head -n 1
+}
+
+#prints tolerance or new-reference if the commit declares that it changes the sound
+declared_change()
+{
+    local commit="$1"
+    local declared
+
+    declared="$(git -C "$repo_dir" log -1 --format=%B "$commit" | sed -n 's/^Golden: *\(tolerance\|new-reference\).*/\1/p' | head -n 1)"
+
+    if [[ -z "$declared" && -f "$sound_changes" ]]; then
+        declared="$(grep -v '^#' "$sound_changes" | while read -r hash kind _; do
+            if [[ -n "$hash" && "$commit" == "$hash"* ]]; then
+                echo "$kind"
+            fi
+        done | head -n 1)"
+    fi
+
+    echo "$declared"
+}
+
+record()
+{
+    local commit="$1"
+    local dest="$2"
+    local golden
+
+    golden="$(build "$commit")"
+    rm -f "$dest"/*.wav "$dest/timings.json"
+    "$golden" --golden-record="$dest"
+}
+
+command="${1:-}"
+
+case "$command" in
+    record)
+        commit="$(git -C "$repo_dir" rev-parse "${2:-$(root_commit)}")"
+        echo "Recording the golden references from $commit"
+        record "$commit" "$golden_dir"
+        ;;
+
+    check)
+        first="$(git -C "$repo_dir" rev-parse "${2:-$(root_commit)}")"
+        last="$(git -C "$repo_dir" rev-parse "${3:-HEAD}")"
+        references="$work_dir/references"
+        failures=()
+
+        #the references move forward only where a commit says it changes the sound
+        echo "Recording the references from $first"
+        record "$first" "$references"
+
+        previous="$first"
+
+        for commit in $(git -C "$repo_dir" rev-list --reverse "$first..$last"); do
+            subject="$(git -C "$repo_dir" log -1 --format='%h %s' "$commit")"
+
+            if git -C "$repo_dir" diff --quiet "$previous" "$commit" -- DSP_Sketchbook; then
+                continue
+            fi
+
+            previous="$commit"
+            declared="$(declared_change "$commit")"
+            echo
+            echo "== $subject${declared:+ ($declared)}"
+
+            if ! golden="$(build "$commit")"; then
+                failures+=("$subject: build")
+                continue
+            fi
+
+            case "$declared" in
+                tolerance)
+                    "$golden" --golden-check="$references" --golden-mode=tolerance || failures+=("$subject")
+                    ;;
+                new-reference)
+                    ;;
+                *)
+                    "$golden" --golden-check="$references" --golden-mode=exact || failures+=("$subject")
+                    ;;
+            esac
+
+            if [[ -n "$declared" ]]; then
+                rm -f "$references"/*.wav "$references/timings.json"
+                "$golden" --golden-record="$references"
+            fi
+        done
+
+        echo
+        echo "Commits failing the golden check: ${#failures[@]}"
+
+        for failure in "${failures[@]+"${failures[@]}"}"; do
+            echo "    $failure"
+        done
+
+        [[ ${#failures[@]} -eq 0 ]]
+        ;;
+
+    *)
+        usage
+        ;;
+esac
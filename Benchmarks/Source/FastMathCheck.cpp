@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    FastMathCheck.cpp
+    Created: 17 Oct 2026 12:08:31am
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "FastMathCheck.h"
+#include <iostream>
+#include <cstdio>
+
+namespace FastMathCheck
+{
+using namespace sketchbook;
+using FastMath::Accuracy;
+
+namespace
+{
+
+constexpr int numPoints = 1 << 20;
+constexpr int numTimingRuns = 50;
+
+//prevents the compiler from optimising away the timed calls
+volatile float sink = 0.f;
+
+struct Function
+{
+    juce::String name;
+    
+    //the range the inputs are spread over
+    double start, end;
+    
+    //the error is divided by the reference, rather than taken as it is
+    bool isRelative;
+    
+    //the inputs run from 2^start to 2^end instead
+    bool isSpreadOverExponent;
+    
+    std::function<double(double)> reference;
+    
+    //per tier, the function under test and the largest error FastMath documents for it
+    std::array<std::function<float(float)>, 3> approximations;
+    std::array<double, 3> maxErrors;
+};
+
+std::vector<Function> getFunctions()
+{
+    return {
+        { "sin2Pi", -4.0, 4.0, false, false,
+            [] (double x) { return std::sin(juce::MathConstants<double>::twoPi * x); },
+            { [] (float x) { return FastMath::sin2Pi<Accuracy::low>(x); },
+              [] (float x) { return FastMath::sin2Pi<Accuracy::medium>(x); },
+              [] (float x) { return FastMath::sin2Pi<Accuracy::high>(x); } },
+            { 8e-5, 1e-6, 2.5e-7 } },
+        
+        { "tanh", -12.0, 12.0, false, false,
+            [] (double x) { return std::tanh(x); },
+            { [] (float x) { return FastMath::tanh<Accuracy::low>(x); },
+              [] (float x) { return FastMath::tanh<Accuracy::medium>(x); },
+              [] (float x) { return FastMath::tanh<Accuracy::high>(x); } },
+            { 2.5e-2, 1.2e-4, 2e-7 } },
+        
+        { "exp2", -32.0, 32.0, true, false,
+            [] (double x) { return std::exp2(x); },
+            { [] (float x) { return FastMath::exp2<Accuracy::low>(x); },
+              [] (float x) { return FastMath::exp2<Accuracy::medium>(x); },
+              [] (float x) { return FastMath::exp2<Accuracy::high>(x); } },
+            { 2e-4, 3e-7, 1.5e-7 } },
+        
+        { "log2", -6.0, 6.0, false, true,
+            [] (double x) { return std::log2(x); },
+            { [] (float x) { return FastMath::log2<Accuracy::low>(x); },
+              [] (float x) { return FastMath::log2<Accuracy::medium>(x); },
+              [] (float x) { return FastMath::log2<Accuracy::high>(x); } },
+            { 1.2e-5, 4e-7, 4e-7 } },
+    };
+}
+
+std::vector<float> getInputs(const Function& function)
+{
+    std::vector<float> inputs((size_t) numPoints);
+    
+    for (int i = 0; i < numPoints; i++)
+    {
+        const double x = function.start + (function.end - function.start) * double(i) / double(numPoints - 1);
+        inputs[(size_t) i] = float(function.isSpreadOverExponent ? std::exp2(x) : x);
+    }
+    
+    return inputs;
+}
+
+double getMaxError(const Function& function, const std::function<float(float)>& approximation, const std::vector<float>& inputs)
+{
+    double maxError = 0.0;
+    
+    for (auto x : inputs)
+    {
+        //the reference is given the same float input, so only the function's own error is measured
+        const double reference = function.reference(double(x));
+        double error = std::abs(double(approximation(x)) - reference);
+        
+        if (function.isRelative)
+            error /= std::abs(reference);
+        
+        maxError = juce::jmax(maxError, error);
+    }
+    
+    return maxError;
+}
+
+template <typename Fn>
+double measureNsPerCall(Fn&& fn, const std::vector<float>& inputs)
+{
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int run = 0; run < numTimingRuns; run++)
+    {
+        float sum = 0.f;
+        
+        for (auto x : inputs)
+            sum += fn(x);
+        
+        sink = sink + sum;
+    }
+    
+    const auto ticks = juce::Time::getHighResolutionTicks() - start;
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / double(numTimingRuns * numPoints);
+}
+
+juce::String formatError(double error)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.2e", error);
+    return text;
+}
+
+//timed with the calls inlined, as they are in the modules
+template <Accuracy accuracy>
+double measureTier(const juce::String& name, const std::vector<float>& inputs)
+{
+    if (name == "sin2Pi") return measureNsPerCall([] (float x) { return FastMath::sin2Pi<accuracy>(x); }, inputs);
+    if (name == "tanh")   return measureNsPerCall([] (float x) { return FastMath::tanh<accuracy>(x); }, inputs);
+    if (name == "exp2")   return measureNsPerCall([] (float x) { return FastMath::exp2<accuracy>(x); }, inputs);
+    return measureNsPerCall([] (float x) { return FastMath::log2<accuracy>(x); }, inputs);
+}
+
+double measureLibm(const juce::String& name, const std::vector<float>& inputs)
+{
+    if (name == "sin2Pi") return measureNsPerCall([] (float x) { return std::sin(x * juce::MathConstants<float>::twoPi); }, inputs);
+    if (name == "tanh")   return measureNsPerCall([] (float x) { return std::tanh(x); }, inputs);
+    if (name == "exp2")   return measureNsPerCall([] (float x) { return std::exp2(x); }, inputs);
+    return measureNsPerCall([] (float x) { return std::log2(x); }, inputs);
+}
+} //end anonymous namespace
+
+//==============================================================================
+bool isRequested(const juce::ArgumentList& args)
+{
+    return args.containsOption("--fast-math");
+}
+
+int run(const juce::ArgumentList&)
+{
+    const juce::StringArray tierNames { "low", "medium", "high" };
+    int numFailed = 0;
+    
+    std::cout << "Fast math against libm (worst error, and ns/call)" << std::endl
+              << juce::String("").paddedRight(' ', 18)
+              << juce::String("error").paddedLeft(' ', 12)
+              << juce::String("documented").paddedLeft(' ', 12)
+              << juce::String("result").paddedLeft(' ', 8)
+              << juce::String("ns/call").paddedLeft(' ', 10)
+              << juce::String("speedup").paddedLeft(' ', 10) << std::endl;
+    
+    for (auto& function : getFunctions())
+    {
+        const auto inputs = getInputs(function);
+        const double libmNs = measureLibm(function.name, inputs);
+        
+        std::cout << (function.name + " libm").paddedRight(' ', 18)
+                  << juce::String("").paddedLeft(' ', 32)
+                  << juce::String(libmNs, 2).paddedLeft(' ', 10) << std::endl;
+        
+        const std::array<double, 3> tierNs { measureTier<Accuracy::low>(function.name, inputs),
+                                             measureTier<Accuracy::medium>(function.name, inputs),
+                                             measureTier<Accuracy::high>(function.name, inputs) };
+        
+        for (size_t tier = 0; tier < 3; tier++)
+        {
+            const double error = getMaxError(function, function.approximations[tier], inputs);
+            const bool passed = error <= function.maxErrors[tier];
+            
+            if (!passed)
+                numFailed++;
+            
+            std::cout << (function.name + " " + tierNames[(int) tier]).paddedRight(' ', 18)
+                      << formatError(error).paddedLeft(' ', 12)
+                      << formatError(function.maxErrors[tier]).paddedLeft(' ', 12)
+                      << juce::String(passed ? "ok" : "FAILED").paddedLeft(' ', 8)
+                      << juce::String(tierNs[tier], 2).paddedLeft(' ', 10)
+                      << juce::String(libmNs / tierNs[tier], 2).paddedLeft(' ', 9) << "x" << std::endl;
+        }
+    }
+    
+    std::cout << "Fast math checks failed: " << numFailed << std::endl;
+    return numFailed > 0 ? 1 : 0;
+}
+}
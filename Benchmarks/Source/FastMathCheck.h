@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    FastMathCheck.h
+    Created: 17 Oct 2026 12:08:31am
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace FastMathCheck
+{
+/**
+ Measures the error of every FastMath function and accuracy tier against
+ libm, and how long each takes per call next to libm.
+     
+     --fast-math         runs the checks and the timings
+ 
+ Returns the process exit code, 1 if an error was larger than FastMath
+ documents
+ */
+int run(const juce::ArgumentList& args);
+
+/** true if the arguments ask for the fast math checks */
+bool isRequested(const juce::ArgumentList& args);
+}
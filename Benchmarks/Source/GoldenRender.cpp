@@ -0,0 +1,287 @@
+/*
+  ==============================================================================
+
+    GoldenRender.cpp
+    Created: 16 Oct 2026 11:58:40pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "GoldenRender.h"
+#include <iostream>
+
+#if SKETCHBOOK_GOLDEN_COMPAT
+ #include "GoldenCompat.h"
+#endif
+
+namespace GoldenRender
+{
+using namespace sketchbook;
+
+//the renderer, which is swapped for one that any commit's engine can build with
+//when checking the history, see Golden/Compat
+#if SKETCHBOOK_GOLDEN_COMPAT
+namespace Render = GoldenCompat;
+#else
+namespace Render = sketchbook;
+#endif
+
+namespace
+{
+
+using Engine = AudioEngine<ModuleList<SimpleOsc>, ModuleList<Delay, Reverb>, ModuleList<LfoModule, EnvelopeModule>>;
+
+constexpr double sampleRate = 48000.0;
+
+struct Scenario
+{
+    juce::String name;
+    int blockSize;
+    double lengthSeconds;
+    std::function<void(juce::MidiBuffer&)> addMidi;
+};
+
+int toSamples(double seconds)
+{
+    return juce::roundToInt(seconds * sampleRate);
+}
+
+//each scenario is made in code, so the midi can never drift from the references
+std::vector<Scenario> getScenarios()
+{
+    return {
+        { "single_note", 512, 3.0, [] (juce::MidiBuffer& midi)
+        {
+            midi.addEvent(juce::MidiMessage::noteOn(1, 60, 1.f), 0);
+            midi.addEvent(juce::MidiMessage::noteOff(1, 60), toSamples(1.0));
+        }},
+        
+        { "chord", 512, 3.5, [] (juce::MidiBuffer& midi)
+        {
+            int i = 0;
+            
+            for (int note : { 48, 55, 60, 64, 67 })
+            {
+                midi.addEvent(juce::MidiMessage::noteOn(1, note, 0.8f), 100 * i++);
+                midi.addEvent(juce::MidiMessage::noteOff(1, note), toSamples(1.5));
+            }
+        }},
+        
+        //an odd block size, with notes and controllers landing part way through blocks
+        { "arpeggio_odd_blocks", 100, 6.0, [] (juce::MidiBuffer& midi)
+        {
+            for (int i = 0; i < 64; i++)
+            {
+                const int note = 48 + (i * 7) % 24;
+                const int start = toSamples(i * 0.0625);
+                midi.addEvent(juce::MidiMessage::noteOn(1, note, 0.5f + 0.5f * float(i % 4) / 3.f), start);
+                midi.addEvent(juce::MidiMessage::noteOff(1, note), start + toSamples(0.05));
+            }
+            
+            for (int i = 0; i < toSamples(4.0); i += 256)
+            {
+                midi.addEvent(juce::MidiMessage::controllerEvent(1, 1, (i / 256) % 128), i);
+                midi.addEvent(juce::MidiMessage::pitchWheel(1, 8192 + (i / 256) % 1024), i);
+            }
+        }},
+        
+        //more notes held than there are voices
+        { "voice_stealing", 512, 5.0, [] (juce::MidiBuffer& midi)
+        {
+            for (int i = 0; i < 48; i++)
+            {
+                const int start = toSamples(i * 0.05);
+                midi.addEvent(juce::MidiMessage::noteOn(1, 36 + i, 1.f), start);
+                midi.addEvent(juce::MidiMessage::noteOff(1, 36 + i), start + toSamples(2.0));
+            }
+        }},
+    };
+}
+
+//==============================================================================
+struct Difference
+{
+    bool lengthsMatch = true;
+    int numDifferentSamples = 0;
+    
+    /** the largest difference of any one sample, in dB full scale */
+    float maxDifferenceDb = -200.f;
+    
+    /** the energy of the difference against the energy of the reference, in dB */
+    double nullDepthDb = -200.0;
+};
+
+Difference compare(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& render)
+{
+    Difference difference;
+    
+    if (reference.getNumChannels() != render.getNumChannels() || reference.getNumSamples() != render.getNumSamples())
+    {
+        difference.lengthsMatch = false;
+        return difference;
+    }
+    
+    float maxDifference = 0.f;
+    double differenceEnergy = 0.0;
+    double referenceEnergy = 0.0;
+    
+    for (int ch = 0; ch < reference.getNumChannels(); ch++)
+    {
+        const auto* ref = reference.getReadPointer(ch);
+        const auto* now = render.getReadPointer(ch);
+        
+        for (int i = 0; i < reference.getNumSamples(); i++)
+        {
+            const float diff = now[i] - ref[i];
+            
+            if (diff != 0.f)
+                difference.numDifferentSamples++;
+            
+            maxDifference = juce::jmax(maxDifference, std::abs(diff));
+            differenceEnergy += double(diff) * double(diff);
+            referenceEnergy += double(ref[i]) * double(ref[i]);
+        }
+    }
+    
+    difference.maxDifferenceDb = juce::Decibels::gainToDecibels(maxDifference, -200.f);
+    
+    if (differenceEnergy > 0.0)
+        difference.nullDepthDb = referenceEnergy > 0.0 ? 10.0 * std::log10(differenceEnergy / referenceEnergy) : 0.0;
+    
+    return difference;
+}
+
+juce::File getTimingsFile(const juce::File& folder)
+{
+    return folder.getChildFile("timings.json");
+}
+
+double getDoubleOption(const juce::ArgumentList& args, const juce::String& option, double defaultValue)
+{
+    return args.containsOption(option) ? args.getValueForOption(option).getDoubleValue() : defaultValue;
+}
+} //end anonymous namespace
+
+//==============================================================================
+bool isRequested(const juce::ArgumentList& args)
+{
+    return args.containsOption("--golden-record") || args.containsOption("--golden-check");
+}
+
+int run(const juce::ArgumentList& args)
+{
+    const bool isRecording = args.containsOption("--golden-record");
+    const auto folder = juce::File::getCurrentWorkingDirectory()
+                            .getChildFile(args.getValueForOption(isRecording ? "--golden-record" : "--golden-check"));
+    
+    const bool isExact = args.getValueForOption("--golden-mode") != "tolerance";
+    const double maxDifferenceDb = getDoubleOption(args, "--max-diff-db", -90.0);
+    const double maxNullDepthDb = getDoubleOption(args, "--null-depth-db", -80.0);
+    
+    Render::RenderSettings settings;
+    settings.sampleRate = sampleRate;
+    settings.numRenderThreads = juce::jmax(1, (int) getDoubleOption(args, "--threads", 1.0));
+    
+    if (isRecording && !folder.createDirectory())
+    {
+        std::cout << "could not create " << folder.getFullPathName() << std::endl;
+        return 1;
+    }
+    
+    auto timings = isRecording ? juce::var(new juce::DynamicObject()) : juce::JSON::parse(getTimingsFile(folder));
+    
+    std::cout << (isRecording ? "Recording golden renders to " : "Checking golden renders in ") << folder.getFullPathName();
+    
+    if (!isRecording)
+        std::cout << (isExact ? " (bit exact)" : " (max diff " + juce::String(maxDifferenceDb, 1) + " dB, null depth "
+                                                 + juce::String(maxNullDepthDb, 1) + " dB)").toStdString();
+    
+    std::cout << std::endl << juce::String("").paddedRight(' ', 24)
+              << juce::String("result").paddedLeft(' ', 10)
+              << juce::String("different").paddedLeft(' ', 12)
+              << juce::String("max diff").paddedLeft(' ', 11)
+              << juce::String("null").paddedLeft(' ', 10)
+              << juce::String("time").paddedLeft(' ', 10)
+              << juce::String("change").paddedLeft(' ', 10) << std::endl;
+    
+    int numFailed = 0;
+    
+    for (auto& scenario : getScenarios())
+    {
+        settings.blockSize = scenario.blockSize;
+        const Render::OfflineRenderer<Engine> renderer(settings);
+        
+        juce::MidiBuffer midi;
+        scenario.addMidi(midi);
+        
+        juce::AudioBuffer<float> render;
+        const double renderSeconds = renderer.renderToBuffer(midi, toSamples(scenario.lengthSeconds), {}, render);
+        
+        const auto file = folder.getChildFile(scenario.name + ".wav");
+        
+        if (isRecording)
+        {
+            //32 bit float, so that the references are exactly what was rendered
+            const auto result = Render::OfflineRender::writeWavFile(file, render, sampleRate, 32);
+            
+            if (result.failed())
+            {
+                std::cout << result.getErrorMessage() << std::endl;
+                return 1;
+            }
+            
+            timings.getDynamicObject()->setProperty(scenario.name, renderSeconds);
+            
+            std::cout << scenario.name.paddedRight(' ', 24)
+                      << juce::String("recorded").paddedLeft(' ', 10)
+                      << juce::String("").paddedLeft(' ', 33)
+                      << juce::String(renderSeconds, 3).paddedLeft(' ', 10) << std::endl;
+            continue;
+        }
+        
+        juce::AudioBuffer<float> reference;
+        double referenceSampleRate = 0.0;
+        const auto result = Render::OfflineRender::readWavFile(file, reference, referenceSampleRate);
+        
+        if (result.failed())
+        {
+            std::cout << scenario.name.paddedRight(' ', 24) << "  " << result.getErrorMessage() << std::endl;
+            numFailed++;
+            continue;
+        }
+        
+        const auto difference = compare(reference, render);
+        
+        const bool passed = difference.lengthsMatch && referenceSampleRate == sampleRate
+                         && (isExact ? difference.numDifferentSamples == 0
+                                     : difference.maxDifferenceDb <= maxDifferenceDb && difference.nullDepthDb <= maxNullDepthDb);
+        
+        if (!passed)
+            numFailed++;
+        
+        const double referenceSeconds = timings.hasProperty(scenario.name) ? double(timings[juce::Identifier(scenario.name)]) : 0.0;
+        const auto change = referenceSeconds > 0.0 ? juce::String((renderSeconds / referenceSeconds - 1.0) * 100.0, 1) + "%"
+                                                   : juce::String("-");
+        
+        std::cout << scenario.name.paddedRight(' ', 24)
+                  << juce::String(passed ? "ok" : "FAILED").paddedLeft(' ', 10);
+        
+        if (difference.lengthsMatch)
+            std::cout << juce::String(difference.numDifferentSamples).paddedLeft(' ', 12)
+                      << juce::String(difference.maxDifferenceDb, 1).paddedLeft(' ', 11)
+                      << juce::String(difference.nullDepthDb, 1).paddedLeft(' ', 10);
+        else
+            std::cout << juce::String("length differs").paddedLeft(' ', 33);
+        
+        std::cout << juce::String(renderSeconds, 3).paddedLeft(' ', 10)
+                  << change.paddedLeft(' ', 10) << std::endl;
+    }
+    
+    if (isRecording)
+        return getTimingsFile(folder).replaceWithText(juce::JSON::toString(timings)) ? 0 : 1;
+    
+    std::cout << "Golden renders failed: " << numFailed << std::endl;
+    return numFailed > 0 ? 1 : 0;
+}
+}
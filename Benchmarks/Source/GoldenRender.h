@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    GoldenRender.h
+    Created: 16 Oct 2026 11:58:40pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace GoldenRender
+{
+/**
+ Renders a fixed set of midi scenarios through the stock modules, SimpleOsc
+ voices with their envelope, and Delay and Reverb as effects, and either
+ stores them as the reference renders or compares them against the stored
+ ones. Used to check that an optimisation did not change the sound.
+     
+     --golden-record=<folder>    writes the reference renders and their timings
+     --golden-check=<folder>     renders again and compares
+     --golden-mode=exact         every sample must match, the default
+     --golden-mode=tolerance     the difference must stay under both limits:
+     --max-diff-db=<dB>          the largest difference of any one sample, -90 by default
+     --null-depth-db=<dB>        the level of the difference against the reference, -80 by default
+     --threads=<n>               the threads the voices are rendered on
+ 
+ Returns the process exit code, 1 if a render did not match
+ */
+int run(const juce::ArgumentList& args);
+
+/** true if the arguments ask for a golden render */
+bool isRequested(const juce::ArgumentList& args);
+}
@@ -0,0 +1,717 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 16 Oct 2026 10:05:12am
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "GoldenRender.h"
+#include "FastMathCheck.h"
+#include <cstring>
+#include <optional>
+
+namespace
+{
+using namespace sketchbook;
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 512;
+constexpr int numBlocks = 2000;
+
+//prevents the compiler from optimising away the rendered audio
+volatile float sink = 0.f;
+
+//==============================================================================
+/**
+ Forces a module through the per sample adapter in Module::processBlock, which
+ is how every module was driven before the block api. Used as the "before"
+ measurement for the block processing benchmarks
+ */
+template <typename ModuleType>
+class PerSampleAdapter : public ModuleType
+{
+public:
+    void processBlock(float* buffer, int startSample, int numSamples) override
+    {
+        Module::processBlock(buffer, startSample, numSamples);
+    }
+};
+
+double ticksToNs(juce::int64 ticks)
+{
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9;
+}
+
+//==============================================================================
+template <typename ModuleType>
+double measureModuleNsPerSample()
+{
+    ModuleType module;
+    module.prepareToPlay(float(sampleRate), blockSize);
+    module.noteOn({ juce::MidiMessage::noteOn(1, 60, 1.f), false, juce::MidiMessage() });
+    module.pitchUpdated(261.63f);
+    
+    //dispatch through the base class, as the voice does
+    Module& mod = module;
+    std::vector<float> buffer((size_t) blockSize);
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int b = 0; b < numBlocks; b++)
+    {
+        std::fill(buffer.begin(), buffer.end(), 1.f);
+        mod.processBlock(buffer.data(), 0, blockSize);
+        sink = sink + buffer[(size_t) blockSize - 1];
+    }
+    
+    return ticksToNs(juce::Time::getHighResolutionTicks() - start) / double(numBlocks * blockSize);
+}
+
+//==============================================================================
+//the cost of keeping a modulation source's value up to date, once per control tick
+template <typename ModuleType>
+double measureControlRateNsPerSample(int controlRate)
+{
+    ModuleType module;
+    module.prepareToPlay(float(sampleRate), blockSize);
+    module.noteOn({ juce::MidiMessage::noteOn(1, 60, 1.f), false, juce::MidiMessage() });
+    
+    Module& mod = module;
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int b = 0; b < numBlocks; b++)
+    {
+        for (int i = 0; i < blockSize; i += controlRate)
+            mod.processControl(controlRate);
+        
+        sink = sink + mod.internalBuffer.getLastSample();
+    }
+    
+    return ticksToNs(juce::Time::getHighResolutionTicks() - start) / double(numBlocks * blockSize);
+}
+
+//==============================================================================
+template <typename VoiceModules, typename ModSources>
+double measureVoiceNsPerSample(int numVoices)
+{
+    AudioEngine<VoiceModules, ModuleList<>, ModSources> engine;
+    engine.prepare(float(sampleRate), blockSize);
+    
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    
+    for (int i = 0; i < numVoices; i++)
+        midi.addEvent(juce::MidiMessage::noteOn(1, 36 + i, 1.f), 0);
+    
+    buffer.clear();
+    engine.process(buffer, midi, 0, blockSize);
+    midi.clear();
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int b = 0; b < numBlocks; b++)
+    {
+        buffer.clear();
+        engine.process(buffer, midi, 0, blockSize);
+        sink = sink + buffer.getSample(0, blockSize - 1);
+    }
+    
+    return ticksToNs(juce::Time::getHighResolutionTicks() - start) / double(numBlocks * blockSize * numVoices);
+}
+
+//==============================================================================
+struct ThreadedRenderResult
+{
+    double nsPerVoiceSample;
+    juce::AudioBuffer<float> lastBlock;
+};
+
+template <typename VoiceModules, typename ModSources>
+ThreadedRenderResult measureThreadedRender(int numVoices, int numThreads)
+{
+    AudioEngine<VoiceModules, ModuleList<>, ModSources> engine;
+    engine.setNumRenderThreads(numThreads);
+    engine.prepare(float(sampleRate), blockSize);
+    
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    
+    for (int i = 0; i < numVoices; i++)
+        midi.addEvent(juce::MidiMessage::noteOn(1, 36 + i, 1.f), 0);
+    
+    buffer.clear();
+    engine.process(buffer, midi, 0, blockSize);
+    midi.clear();
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int b = 0; b < numBlocks; b++)
+    {
+        buffer.clear();
+        engine.process(buffer, midi, 0, blockSize);
+        sink = sink + buffer.getSample(0, blockSize - 1);
+    }
+    
+    const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+    
+    return { ticksToNs(elapsed) / double(numBlocks * blockSize * numVoices), buffer };
+}
+
+//==============================================================================
+/**
+ Eight held voices under a stream of midi. A controller and pitch bend arrive
+ every ccInterval samples and a note starts and stops every noteInterval
+ samples, 0 turns either off
+ */
+double measureMidiStormNsPerSample(int ccInterval, int noteInterval, int minSubBlockSize)
+{
+    AudioEngine<ModuleList<SimpleOsc>, ModuleList<>, ModuleList<LfoModule, EnvelopeModule>> engine;
+    engine.setMinimumSubBlockSize(minSubBlockSize);
+    engine.prepare(float(sampleRate), blockSize);
+    
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    
+    for (int i = 0; i < 8; i++)
+        midi.addEvent(juce::MidiMessage::noteOn(1, 48 + i, 1.f), 0);
+    
+    buffer.clear();
+    engine.process(buffer, midi, 0, blockSize);
+    
+    //the same storm is played into every block
+    midi.clear();
+    
+    for (int i = 0; ccInterval > 0 && i < blockSize; i += ccInterval)
+    {
+        midi.addEvent(juce::MidiMessage::controllerEvent(1, 1, (i / ccInterval) % 128), i);
+        midi.addEvent(juce::MidiMessage::pitchWheel(1, 8192 + (i % 512)), i);
+    }
+    
+    for (int i = 0; noteInterval > 0 && i < blockSize; i += noteInterval)
+    {
+        const int note = 72 + (i / noteInterval) % 12;
+        midi.addEvent(juce::MidiMessage::noteOn(1, note, 1.f), i);
+        midi.addEvent(juce::MidiMessage::noteOff(1, note), juce::jmin(blockSize - 1, i + noteInterval / 2));
+    }
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int b = 0; b < numBlocks; b++)
+    {
+        buffer.clear();
+        engine.process(buffer, midi, 0, blockSize);
+        sink = sink + buffer.getSample(0, blockSize - 1);
+    }
+    
+    return ticksToNs(juce::Time::getHighResolutionTicks() - start) / double(numBlocks * blockSize);
+}
+
+//==============================================================================
+//the cost of one playing voice should not depend on how many voices are allocated
+template <int Polyphony>
+double measurePolyphonyNsPerSample(int numPlayingVoices)
+{
+    auto engine = std::make_unique<AudioEngine<ModuleList<SimpleOsc>, ModuleList<>, ModuleList<LfoModule, EnvelopeModule>, Polyphony>>();
+    engine->prepare(float(sampleRate), blockSize);
+    
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    
+    for (int i = 0; i < numPlayingVoices; i++)
+        midi.addEvent(juce::MidiMessage::noteOn(1, i % 128, 1.f), 0);
+    
+    buffer.clear();
+    engine->process(buffer, midi, 0, blockSize);
+    midi.clear();
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int b = 0; b < numBlocks; b++)
+    {
+        buffer.clear();
+        engine->process(buffer, midi, 0, blockSize);
+        sink = sink + buffer.getSample(0, blockSize - 1);
+    }
+    
+    return ticksToNs(juce::Time::getHighResolutionTicks() - start) / double(numBlocks * blockSize);
+}
+
+//==============================================================================
+//the same noise is played into every block, so each run processes the same audio
+juce::AudioBuffer<float> makeNoise(int numSamples)
+{
+    juce::AudioBuffer<float> noise(2, numSamples);
+    juce::Random random(1);
+    
+    for (int ch = 0; ch < noise.getNumChannels(); ch++)
+        for (int i = 0; i < numSamples; i++)
+            noise.setSample(ch, i, random.nextFloat() * 0.5f - 0.25f);
+    
+    return noise;
+}
+
+/**
+ Gives a Convolution a decaying noise impulse response of the length the
+ module loads from file, as the file is not there on most machines, and waits
+ for the background loader to swap it in
+ */
+void loadSyntheticImpulseResponse(Convolution& convolution, double rate, int size)
+{
+    constexpr int irLength = 1024;
+    
+    auto impulseResponse = makeNoise(irLength);
+    
+    for (int ch = 0; ch < impulseResponse.getNumChannels(); ch++)
+        for (int i = 0; i < irLength; i++)
+            impulseResponse.setSample(ch, i, impulseResponse.getSample(ch, i) * std::exp(-6.f * float(i) / float(irLength)));
+    
+    convolution.loadImpulseResponse(std::move(impulseResponse), rate);
+    
+    juce::AudioBuffer<float> silence(2, size);
+    
+    for (int tries = 0; tries < 2000 && convolution.getTailLengthSeconds() <= 0.0; tries++)
+    {
+        silence.clear();
+        convolution.process(silence);
+        juce::Thread::sleep(1);
+    }
+    
+    //otherwise only the pass through would be timed
+    jassert(convolution.getTailLengthSeconds() > 0.0);
+    convolution.reset();
+}
+
+/**
+ Runs a list of effects over stereo noise as the engine's fx chain does. The
+ same length of audio is rendered at every block size
+ */
+template <typename FxModules>
+double measureFxNsPerSample(double rate, int size)
+{
+    FxModules fxChain;
+    
+    fxChain.forEach([&] (auto& mod, auto)
+    {
+        mod.prepareToPlay(float(rate), size);
+        mod.prepareEnableFade(float(rate), size, 2);
+        
+        if constexpr (std::is_same_v<std::decay_t<decltype(mod)>, Convolution>)
+            loadSyntheticImpulseResponse(mod, rate, size);
+    });
+    
+    const auto noise = makeNoise(size);
+    juce::AudioBuffer<float> buffer(2, size);
+    const int numFxBlocks = numBlocks * blockSize / size;
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int b = 0; b < numFxBlocks; b++)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ch++)
+            buffer.copyFrom(ch, 0, noise, ch, 0, size);
+        
+        fxChain.forEach([&] (auto& mod, auto)
+        {
+            mod.runModulations();
+            mod.processWithEnableFade(buffer);
+        });
+        
+        sink = sink + buffer.getSample(0, size - 1);
+    }
+    
+    return ticksToNs(juce::Time::getHighResolutionTicks() - start) / double(numFxBlocks * size);
+}
+
+//==============================================================================
+/**
+ The results of the regression suite, by name, in ns/sample. They are written
+ as json, and a later run can be compared against them to catch a change that
+ made the engine slower.
+ 
+ Thresholds are percentages that a result may grow by before it counts as a
+ regression. They are read from the baseline's "thresholds" object, by result
+ name, so a noisy benchmark can be given more room by editing the baseline
+ file. Other results use --threshold when it is given, then the baseline's
+ "default" entry, then 10%. The default is only written when --threshold is.
+ */
+class BenchmarkReport
+{
+public:
+    void add(const juce::String& name, double nsPerSample)
+    {
+        results.set(juce::Identifier(name), nsPerSample);
+        
+        std::cout << name.paddedRight(' ', 40)
+                  << juce::String(nsPerSample, 2).paddedLeft(' ', 12) << std::endl;
+    }
+    
+    bool writeJson(const juce::File& file, std::optional<double> defaultThreshold) const
+    {
+        auto* resultsObject = new juce::DynamicObject();
+        
+        for (auto& result : results)
+            resultsObject->setProperty(result.name, result.value);
+        
+        //left empty unless asked for, so a later --threshold is not overridden by this run's
+        auto* thresholds = new juce::DynamicObject();
+        
+        if (defaultThreshold.has_value())
+            thresholds->setProperty("default", *defaultThreshold);
+        
+        auto* report = new juce::DynamicObject();
+        report->setProperty("unit", "ns/sample");
+        report->setProperty("sampleRate", sampleRate);
+        report->setProperty("blockSize", blockSize);
+        report->setProperty("results", juce::var(resultsObject));
+        report->setProperty("thresholds", juce::var(thresholds));
+        
+        return file.replaceWithText(juce::JSON::toString(juce::var(report)));
+    }
+    
+    /** prints each result against the baseline and returns the number that got slower than their threshold allows */
+    int compareWith(const juce::var& baseline, std::optional<double> explicitThreshold) const
+    {
+        const auto baselineResults = baseline["results"];
+        const auto thresholds = baseline["thresholds"];
+        
+        double defaultThreshold = 10.0;
+        
+        if (explicitThreshold.has_value())
+            defaultThreshold = *explicitThreshold;
+        else if (thresholds.hasProperty("default"))
+            defaultThreshold = thresholds["default"];
+        
+        std::cout << std::endl << "Against the baseline" << std::endl;
+        std::cout << juce::String("").paddedRight(' ', 40)
+                  << juce::String("baseline").paddedLeft(' ', 12)
+                  << juce::String("now").paddedLeft(' ', 12)
+                  << juce::String("change").paddedLeft(' ', 11)
+                  << juce::String("allowed").paddedLeft(' ', 10) << std::endl;
+        
+        int numRegressions = 0;
+        
+        for (auto& result : results)
+        {
+            if (!baselineResults.hasProperty(result.name))
+                continue;
+            
+            const double before = baselineResults[result.name];
+            const double now = result.value;
+            const double threshold = thresholds.hasProperty(result.name) ? double(thresholds[result.name]) : defaultThreshold;
+            const double change = before > 0.0 ? (now / before - 1.0) * 100.0 : 0.0;
+            const bool isRegression = change > threshold;
+            
+            if (isRegression)
+                numRegressions++;
+            
+            std::cout << result.name.toString().paddedRight(' ', 40)
+                      << juce::String(before, 2).paddedLeft(' ', 12)
+                      << juce::String(now, 2).paddedLeft(' ', 12)
+                      << juce::String(change, 1).paddedLeft(' ', 10) << "%"
+                      << juce::String(threshold, 1).paddedLeft(' ', 9) << "%"
+                      << (isRegression ? "  REGRESSION" : "") << std::endl;
+        }
+        
+        return numRegressions;
+    }
+    
+private:
+    //keeps the order results were added in
+    juce::NamedValueSet results;
+};
+
+//==============================================================================
+void printResult(const juce::String& name, double before, double after)
+{
+    std::cout << name.paddedRight(' ', 28)
+              << juce::String(before, 2).paddedLeft(' ', 12)
+              << juce::String(after, 2).paddedLeft(' ', 12)
+              << juce::String(before / after, 2).paddedLeft(' ', 10) << "x" << std::endl;
+}
+
+void runBlockProcessingBenchmarks()
+{
+    std::cout << "Block processing (ns/sample, " << sampleRate << " Hz, " << blockSize << " sample blocks)" << std::endl;
+    std::cout << juce::String("").paddedRight(' ', 28)
+              << juce::String("per sample").paddedLeft(' ', 12)
+              << juce::String("block").paddedLeft(' ', 12)
+              << juce::String("speedup").paddedLeft(' ', 11) << std::endl;
+    
+    printResult("Simple Osc",
+                measureModuleNsPerSample<PerSampleAdapter<SimpleOsc>>(),
+                measureModuleNsPerSample<SimpleOsc>());
+    
+    printResult("LFO",
+                measureModuleNsPerSample<PerSampleAdapter<LfoModule>>(),
+                measureModuleNsPerSample<LfoModule>());
+    
+    printResult("ADSR",
+                measureModuleNsPerSample<PerSampleAdapter<EnvelopeModule>>(),
+                measureModuleNsPerSample<EnvelopeModule>());
+    
+    for (int numVoices : { 1, 8, 32 })
+    {
+        printResult("Voice (per voice) x" + juce::String(numVoices),
+                    measureVoiceNsPerSample<ModuleList<PerSampleAdapter<SimpleOsc>>,
+                                            ModuleList<PerSampleAdapter<LfoModule>, PerSampleAdapter<EnvelopeModule>>>(numVoices),
+                    measureVoiceNsPerSample<ModuleList<SimpleOsc>,
+                                            ModuleList<LfoModule, EnvelopeModule>>(numVoices));
+    }
+}
+
+void runOscillatorBenchmarks()
+{
+    std::cout << std::endl << "Oscillators (ns/sample)" << std::endl;
+    std::cout << juce::String("").paddedRight(' ', 28)
+              << juce::String("simple").paddedLeft(' ', 12)
+              << juce::String("wavetable").paddedLeft(' ', 12)
+              << juce::String("speedup").paddedLeft(' ', 11) << std::endl;
+    
+    printResult("Module", measureModuleNsPerSample<SimpleOsc>(), measureModuleNsPerSample<WavetableOsc>());
+    
+    for (int numVoices : { 1, 8, 32 })
+    {
+        printResult("Voice (per voice) x" + juce::String(numVoices),
+                    measureVoiceNsPerSample<ModuleList<SimpleOsc>, ModuleList<LfoModule, EnvelopeModule>>(numVoices),
+                    measureVoiceNsPerSample<ModuleList<WavetableOsc>, ModuleList<LfoModule, EnvelopeModule>>(numVoices));
+    }
+}
+
+void runControlRateBenchmarks()
+{
+    std::cout << std::endl << "Modulation sources (ns/sample, rendered per sample vs evaluated per control tick)" << std::endl;
+    
+    for (int controlRate : { 16, 32, 64 })
+    {
+        printResult("LFO every " + juce::String(controlRate),
+                    measureModuleNsPerSample<LfoModule>(),
+                    measureControlRateNsPerSample<LfoModule>(controlRate));
+        
+        printResult("ADSR every " + juce::String(controlRate),
+                    measureModuleNsPerSample<EnvelopeModule>(),
+                    measureControlRateNsPerSample<EnvelopeModule>(controlRate));
+    }
+}
+
+void runMidiStormBenchmarks()
+{
+    std::cout << std::endl << "MIDI storms (ns/sample for the whole engine, 8 held voices)" << std::endl;
+    std::cout << juce::String("").paddedRight(' ', 28)
+              << juce::String("no midi").paddedLeft(' ', 12)
+              << juce::String("storm").paddedLeft(' ', 12)
+              << juce::String("overhead").paddedLeft(' ', 11) << std::endl;
+    
+    const double quiet = measureMidiStormNsPerSample(0, 0, 32);
+    
+    auto printRow = [quiet] (const juce::String& name, double storm)
+    {
+        std::cout << name.paddedRight(' ', 28)
+                  << juce::String(quiet, 2).paddedLeft(' ', 12)
+                  << juce::String(storm, 2).paddedLeft(' ', 12)
+                  << juce::String(storm / quiet, 2).paddedLeft(' ', 10) << "x" << std::endl;
+    };
+    
+    //controllers never split the block, so the split size should make no difference here
+    printRow("CC every 2 samples", measureMidiStormNsPerSample(2, 0, 32));
+    
+    for (int minSubBlockSize : { 1, 16, 32, 64 })
+        printRow("Notes every 8, split " + juce::String(minSubBlockSize), measureMidiStormNsPerSample(2, 8, minSubBlockSize));
+}
+
+void runPolyphonyBenchmarks()
+{
+    std::cout << std::endl << "Polyphony (ns/sample for the whole engine)" << std::endl;
+    std::cout << juce::String("voices allocated").paddedRight(' ', 28)
+              << juce::String("1 playing").paddedLeft(' ', 12)
+              << juce::String("all playing").paddedLeft(' ', 12) << std::endl;
+    
+    auto printRow = [] (int polyphony, double one, double all)
+    {
+        std::cout << juce::String(polyphony).paddedRight(' ', 28)
+                  << juce::String(one, 2).paddedLeft(' ', 12)
+                  << juce::String(all, 2).paddedLeft(' ', 12) << std::endl;
+    };
+    
+    printRow(32,  measurePolyphonyNsPerSample<32>(1),  measurePolyphonyNsPerSample<32>(32));
+    printRow(128, measurePolyphonyNsPerSample<128>(1), measurePolyphonyNsPerSample<128>(128));
+    printRow(256, measurePolyphonyNsPerSample<256>(1), measurePolyphonyNsPerSample<256>(256));
+}
+
+void runThreadScalingBenchmarks()
+{
+    constexpr int numVoices = 32;
+    const int maxThreads = juce::SystemStats::getNumCpus();
+    
+    std::cout << std::endl << "Voice rendering threads (" << numVoices << " voices, ns/voice/sample)" << std::endl;
+    std::cout << juce::String("threads").paddedRight(' ', 28)
+              << juce::String("time").paddedLeft(' ', 12)
+              << juce::String("speedup").paddedLeft(' ', 11)
+              << juce::String("matches x1").paddedLeft(' ', 12) << std::endl;
+    
+    using Modules = ModuleList<SimpleOsc, SimpleOsc>;
+    using Sources = ModuleList<LfoModule, LfoModule, EnvelopeModule, EnvelopeModule>;
+    
+    const auto serial = measureThreadedRender<Modules, Sources>(numVoices, 1);
+    
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads++)
+    {
+        const auto result = numThreads == 1 ? serial : measureThreadedRender<Modules, Sources>(numVoices, numThreads);
+        
+        //the threaded render must be bit exact with the serial one
+        bool matches = true;
+        
+        for (int ch = 0; ch < serial.lastBlock.getNumChannels(); ch++)
+            matches = matches && std::memcmp(serial.lastBlock.getReadPointer(ch), result.lastBlock.getReadPointer(ch),
+                                             sizeof(float) * (size_t) blockSize) == 0;
+        
+        std::cout << juce::String(numThreads).paddedRight(' ', 28)
+                  << juce::String(result.nsPerVoiceSample, 2).paddedLeft(' ', 12)
+                  << juce::String(serial.nsPerVoiceSample / result.nsPerVoiceSample, 2).paddedLeft(' ', 10) << "x"
+                  << juce::String(matches ? "yes" : "NO").paddedLeft(' ', 12) << std::endl;
+    }
+}
+
+//==============================================================================
+/**
+ The results that are kept and compared between runs: every stock module,
+ a voice as modules are added, the engine as voices are added, and the fx
+ chain at several block sizes and sample rates
+ */
+void runRegressionSuite(BenchmarkReport& report)
+{
+    std::cout << std::endl << "Regression suite (ns/sample)" << std::endl;
+    
+    report.add("module/Simple Osc", measureModuleNsPerSample<SimpleOsc>());
+    report.add("module/Wavetable Osc", measureModuleNsPerSample<WavetableOsc>());
+    report.add("module/LFO", measureModuleNsPerSample<LfoModule>());
+    report.add("module/ADSR", measureModuleNsPerSample<EnvelopeModule>());
+    report.add("module/Delay", measureFxNsPerSample<ModuleList<Delay>>(sampleRate, blockSize));
+    report.add("module/Reverb", measureFxNsPerSample<ModuleList<Reverb>>(sampleRate, blockSize));
+    report.add("module/Distortion", measureFxNsPerSample<ModuleList<Distortion>>(sampleRate, blockSize));
+    report.add("module/Distortion x4 oversampled", measureFxNsPerSample<ModuleList<Oversampled<Distortion, 4>>>(sampleRate, blockSize));
+    
+    report.add("module/Convolution", measureFxNsPerSample<ModuleList<Convolution>>(sampleRate, blockSize));
+    
+    //per voice, with 8 voices playing
+    using Sources = ModuleList<LfoModule, EnvelopeModule>;
+    report.add("voice/1 module", measureVoiceNsPerSample<ModuleList<SimpleOsc>, Sources>(8));
+    report.add("voice/2 modules", measureVoiceNsPerSample<ModuleList<SimpleOsc, SimpleOsc>, Sources>(8));
+    report.add("voice/4 modules", measureVoiceNsPerSample<ModuleList<SimpleOsc, SimpleOsc, SimpleOsc, SimpleOsc>, Sources>(8));
+    report.add("voice/8 modules", measureVoiceNsPerSample<ModuleList<SimpleOsc, SimpleOsc, SimpleOsc, SimpleOsc,
+                                                                     SimpleOsc, SimpleOsc, SimpleOsc, SimpleOsc>, Sources>(8));
+    
+    //the whole engine
+    for (int numVoices : { 1, 2, 4, 8, 16, 32, 64 })
+        report.add("polyphony/" + juce::String(numVoices) + " voices", measurePolyphonyNsPerSample<64>(numVoices));
+    
+    using FxChain = ModuleList<Delay, Reverb, Distortion, Convolution>;
+    
+    for (double rate : { 44100.0, 48000.0, 96000.0 })
+        for (int size : { 64, 256, 1024 })
+            report.add("fx chain/" + juce::String(rate / 1000.0, 1) + "k " + juce::String(size),
+                       measureFxNsPerSample<FxChain>(rate, size));
+}
+
+void printUsage()
+{
+    std::cout << "usage: Sketchbook_Benchmarks [--suite-only] [--json=<file>] [--baseline=<file>] [--threshold=<percent>]" << std::endl
+              << std::endl
+              << "--json writes the regression suite's results, which can be used as a later run's --baseline." << std::endl
+              << "A result that is slower than the baseline by more than its threshold fails the run." << std::endl
+              << std::endl
+              << "       Sketchbook_Benchmarks --golden-record=<folder> | --golden-check=<folder>" << std::endl
+              << "                             [--golden-mode=exact|tolerance] [--max-diff-db=-90] [--null-depth-db=-80] [--threads=<n>]" << std::endl
+              << std::endl
+              << "Renders fixed scenarios through the stock modules and stores them, or compares them with the stored renders." << std::endl
+              << std::endl
+              << "       Sketchbook_Benchmarks --fast-math" << std::endl
+              << std::endl
+              << "Checks the FastMath approximations against libm, and times them." << std::endl;
+}
+} //end anonymous namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+    
+    if (args.containsOption("--help"))
+    {
+        printUsage();
+        return 0;
+    }
+    
+    if (GoldenRender::isRequested(args))
+        return GoldenRender::run(args);
+    
+    if (FastMathCheck::isRequested(args))
+        return FastMathCheck::run(args);
+    
+    //the percentage a result may grow by, see BenchmarkReport
+    std::optional<double> threshold;
+    
+    if (args.containsOption("--threshold"))
+        threshold = args.getValueForOption("--threshold").getDoubleValue();
+    
+    //report rather than break, so that a whole run can be checked
+    RealtimeAuditor::setViolationAction(RealtimeAuditor::ViolationAction::logMessage);
+    
+    if (!args.containsOption("--suite-only"))
+    {
+        runBlockProcessingBenchmarks();
+        runOscillatorBenchmarks();
+        runControlRateBenchmarks();
+        runMidiStormBenchmarks();
+        runPolyphonyBenchmarks();
+        runThreadScalingBenchmarks();
+    }
+    
+    BenchmarkReport report;
+    runRegressionSuite(report);
+    
+    if (args.containsOption("--json"))
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--json"));
+        
+        if (!report.writeJson(file, threshold))
+        {
+            std::cout << "could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    
+    if (args.containsOption("--baseline"))
+    {
+        const auto baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--baseline"));
+        const auto baseline = juce::JSON::parse(baselineFile);
+        
+        if (!baseline.isObject())
+        {
+            std::cout << "could not read a baseline from " << baselineFile.getFullPathName() << std::endl;
+            return 1;
+        }
+        
+        const int numRegressions = report.compareWith(baseline, threshold);
+        std::cout << "Regressions: " << numRegressions << std::endl;
+        
+        if (numRegressions > 0)
+            return 1;
+    }
+    
+    if (RealtimeAuditor::isEnabled())
+    {
+        std::cout << "Real-time allocations: " << RealtimeAuditor::getNumViolations() << std::endl;
+        
+        if (RealtimeAuditor::getNumViolations() > 0)
+            return 1;
+    }
+    
+    return 0;
+}
@@ -6,3 +6,11 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new DSPSketchbookAudioProcessor<VoiceModules, EffectsModules, ModulationSourceModules>();        \
 }                                                                                                           \
 
+//as above, with the number of voices set explicitly (the default is 32)
+#define SKETCHBOOK_DECLARE_APP_WITH_POLYPHONY(Name, VoiceModules, EffectsModules, ModulationSourceModules, Polyphony) \
+                                                                                                            \
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()                                                    \
+{                                                                                                           \
+    return new DSPSketchbookAudioProcessor<VoiceModules, EffectsModules, ModulationSourceModules, Polyphony>(); \
+}                                                                                                           \
+
@@ -17,7 +17,8 @@
 */
 template <typename VoiceModules,
           typename FxModules,
-          typename ModulationSources>
+          typename ModulationSources,
+          int Polyphony = 32>
 
 class DSPSketchbookAudioProcessor  : public juce::AudioProcessor
 {
@@ -39,11 +40,8 @@ public:
         //TODO: this should change - not be a pointer
         context.audioBufferQueue = &audioBufferQueue;
         context.parameterData = audioEngine.getPluginData();
-        
-        context.getLatestPlayingModuleByName = [this] (juce::String name)
-        {
-            return audioEngine.getLatestPlayingModuleByName(name);
-        };
+        context.modulationTelemetry = &audioEngine.getModulationTelemetry();
+        context.moduleProfiler = &audioEngine.getModuleProfiler();
     }
 
     ~DSPSketchbookAudioProcessor()
@@ -85,7 +83,7 @@ public:
 
     double getTailLengthSeconds() const
     {
-        return 0.0;
+        return audioEngine.getTailLengthSeconds();
     }
 
     int getNumPrograms()
@@ -118,7 +116,8 @@ public:
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock)
     {
-        audioEngine.prepare(float(sampleRate), samplesPerBlock);
+        audioEngine.prepare(float(sampleRate), samplesPerBlock, getTotalNumOutputChannels());
+        setLatencySamples(juce::roundToInt(audioEngine.getLatencyInSamples()));
         context.midiMessageCollector.reset (float(sampleRate));
     }
 
@@ -181,20 +180,17 @@ public:
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData)
     {
-        juce::ignoreUnused(destData);
-        // You should use this method to store your parameters in the memory block.
-        // You could do that either as raw data, or use the XML or ValueTree classes
-        // as intermediaries to make it easy to save and load complex data.
+        if (auto xml = audioEngine.getState().createXml())
+            copyXmlToBinary(*xml, destData);
     }
 
     void setStateInformation (const void* data, int sizeInBytes)
     {
-        juce::ignoreUnused(data, sizeInBytes);
-        // You should use this method to restore your parameters from this memory block,
-        // whose contents will have been created by the getStateInformation() call.
+        if (auto xml = getXmlFromBinary(data, sizeInBytes))
+            audioEngine.setState(juce::ValueTree::fromXml(*xml));
     }
 
-    sketchbook::AudioEngine<VoiceModules, FxModules, ModulationSources> audioEngine;
+    sketchbook::AudioEngine<VoiceModules, FxModules, ModulationSources, Polyphony> audioEngine;
     
 private:
     //==============================================================================
@@ -23,14 +23,24 @@
 #include "Resources/BinaryData/DSP_SKETCHBOOK_BINARY.cpp"
 
 //ENGINE
+#include "Engine/RealtimeAuditor.cpp"
+#include "Engine/VoiceThreadPool.cpp"
+#include "Engine/EffectsPipeline.cpp"
+#include "Engine/MidiScheduler.cpp"
+#include "Engine/ParameterQueue.cpp"
+#include "Engine/ModulationTelemetry.cpp"
+#include "Engine/ModuleProfiler.cpp"
+#include "Engine/Smoothing.cpp"
 #include "Engine/Module.cpp"
 #include "Engine/Voices.cpp"
+#include "Engine/OfflineRenderer.cpp"
 //#include "Engine/Engine.cpp"
 
 //MODULES
 #include "Modules/EnvelopeModule.cpp"
 #include "Modules/ModulationSources.cpp"
 #include "Modules/Delay.cpp"
+#include "Modules/WavetableOsc.cpp"
 
 #include "Modules/Reverb.cpp"
 #include "Modules/DragonFlyReverb/DSP.cpp"
@@ -22,6 +22,32 @@
 #pragma once
 #define DSP_SKETCHBOOK_INCLUDED
 
+/** Config: SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS
+    Replaces the global operator new/delete so that any allocation made while
+    AudioEngine::process is running is reported by the RealtimeAuditor. Intended
+    for debug and test builds only.
+*/
+#ifndef SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS
+ #define SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS 0
+#endif
+
+/** Config: SKETCHBOOK_ENABLE_VOICE_LANES
+    Renders voices in groups, one voice per SIMD lane, for modules that provide
+    processLanes (see VoiceLanes.h). Has no effect when JUCE_USE_SIMD is off.
+*/
+#ifndef SKETCHBOOK_ENABLE_VOICE_LANES
+ #define SKETCHBOOK_ENABLE_VOICE_LANES 1
+#endif
+
+/** Config: SKETCHBOOK_ENABLE_PROFILING
+    Counts the cycles spent in each module, in the modulation and in each
+    effect, and shows them on the Performance page. When off the probes
+    compile to nothing.
+*/
+#ifndef SKETCHBOOK_ENABLE_PROFILING
+ #define SKETCHBOOK_ENABLE_PROFILING 0
+#endif
+
 //Necesary juce includes
 #include <juce_core/juce_core.h>
 #include <juce_data_structures/juce_data_structures.h>
@@ -37,6 +63,8 @@ namespace sketchbook
 {
 class AudioBufferQueue;
 class Module;
+class ModulationTelemetry;
+class ModuleProfiler;
 struct Context
 {
     juce::MidiKeyboardState midiKeyboardState;
@@ -44,10 +72,11 @@ struct Context
     juce::MidiMessageCollector midiMessageCollector;
     sketchbook::AudioBufferQueue* audioBufferQueue;
     
-    //TODO: this is here as a work around to acessing
-    //TODO: unknown templated functions, a beter method should
-    //TODO: probably be found
-    std::function<sketchbook::Module*(juce::String)> getLatestPlayingModuleByName;
+    //the latest modulated parameter values, for display
+    sketchbook::ModulationTelemetry* modulationTelemetry = nullptr;
+    
+    //the cycles spent in each module, for the performance page
+    sketchbook::ModuleProfiler* moduleProfiler = nullptr;
 };
 }
 
@@ -55,9 +84,22 @@ struct Context
 #include "Resources/BinaryData/DSP_SKETCHBOOK_BINARY.h"
 
 //ENGINE
+#include "Engine/RealtimeAuditor.h"
+#include "Engine/VoiceThreadPool.h"
+#include "Engine/EffectsPipeline.h"
+#include "Engine/MidiScheduler.h"
+#include "Engine/ParameterQueue.h"
+#include "Engine/ParameterSchema.h"
+#include "Engine/ModulationTelemetry.h"
+#include "Engine/ModuleProfiler.h"
+#include "Engine/Smoothing.h"
+#include "Engine/FastMath.h"
+#include "Engine/VoiceLanes.h"
 #include "Engine/Engine.h"
 #include "Engine/Module.h"
+#include "Engine/Oversampled.h"
 #include "Engine/Voices.h"
+#include "Engine/OfflineRenderer.h"
 
 //MODULES
 #include "Modules/EnvelopeModule.h"
@@ -67,6 +109,7 @@ struct Context
 #include "Modules/FX.h"
 #include "Modules/ModulationSources.h"
 #include "Modules/SimpleOsc.h"
+#include "Modules/WavetableOsc.h"
 
 //APP
 #include "App/AppDecl.h"
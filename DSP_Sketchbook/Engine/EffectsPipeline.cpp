@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    EffectsPipeline.cpp
+    Created: 16 Oct 2026 11:59:12pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "EffectsPipeline.h"
+#include "RealtimeAuditor.h"
+
+namespace sketchbook
+{
+
+EffectsPipeline::~EffectsPipeline()
+{
+    release();
+}
+
+void EffectsPipeline::prepare(int _numChannels, int _blockSize, ProcessEffects _processEffects)
+{
+    release();
+    
+    processEffects = std::move(_processEffects);
+    numChannels = _numChannels;
+    blockSize = juce::jmax(1, _blockSize);
+    
+    for (auto& block : blocks)
+        block.setSize(numChannels, blockSize);
+    
+    fillingIndex = 0;
+    numFilled = 0;
+    completeIndex = -1;
+    workIndex = -1;
+    
+    //the output starts a block of silence ahead, which is the latency
+    output.setSize(numChannels, blockSize * 3);
+    output.clear();
+    outputStart = 0;
+    numOutput = blockSize;
+    
+    worker = std::make_unique<Worker>(*this);
+    worker->startRealtimeThread(juce::Thread::RealtimeOptions{});
+}
+
+void EffectsPipeline::release()
+{
+    if (worker == nullptr)
+        return;
+    
+    worker->signalThreadShouldExit();
+    worker->notify();
+    worker->stopThread(1000);
+    worker.reset();
+}
+
+void EffectsPipeline::startCompleteBlock()
+{
+    if (completeIndex < 0)
+        return;
+    
+    workIndex = completeIndex;
+    completeIndex = -1;
+    
+    isBusy.store(true, std::memory_order_relaxed);
+    hasWork.store(true, std::memory_order_release);
+    worker->notify();
+}
+
+void EffectsPipeline::pushVoices(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    const int channelsToCopy = juce::jmin(numChannels, buffer.getNumChannels());
+    
+    while (numSamples > 0)
+    {
+        auto& block = blocks[(size_t) fillingIndex];
+        const int numToCopy = juce::jmin(numSamples, blockSize - numFilled);
+        
+        for (int ch = 0; ch < channelsToCopy; ch++)
+            block.copyFrom(ch, numFilled, buffer, ch, startSample, numToCopy);
+        
+        for (int ch = channelsToCopy; ch < numChannels; ch++)
+            block.clear(ch, numFilled, numToCopy);
+        
+        numFilled += numToCopy;
+        startSample += numToCopy;
+        numSamples -= numToCopy;
+        
+        if (numFilled == blockSize)
+        {
+            //calls are no longer than a block, so the last complete block has been started by now
+            jassert(completeIndex < 0);
+            
+            completeIndex = fillingIndex;
+            numFilled = 0;
+            
+            //carry on in the block that is neither complete nor with the effects thread
+            for (int i = 0; i < (int) blocks.size(); i++)
+                if (i != completeIndex && i != workIndex)
+                    fillingIndex = i;
+        }
+    }
+}
+
+void EffectsPipeline::finishBlocks(int numSamplesNeeded)
+{
+    //the effects thread never carries on past the end of a call
+    if (workIndex >= 0)
+    {
+        while (isBusy.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        
+        collect(workIndex);
+        workIndex = -1;
+    }
+    
+    //a block completed part way through this call may already be needed
+    if (numOutput < numSamplesNeeded && completeIndex >= 0)
+    {
+        processEffects(blocks[(size_t) completeIndex]);
+        collect(completeIndex);
+        completeIndex = -1;
+    }
+    
+    jassert(numOutput >= numSamplesNeeded);
+}
+
+void EffectsPipeline::pullOutput(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    const int channelsToCopy = juce::jmin(numChannels, buffer.getNumChannels());
+    const int outputSize = output.getNumSamples();
+    const int firstPart = juce::jmin(numSamples, outputSize - outputStart);
+    
+    for (int ch = 0; ch < channelsToCopy; ch++)
+    {
+        buffer.copyFrom(ch, startSample, output, ch, outputStart, firstPart);
+        
+        if (firstPart < numSamples)
+            buffer.copyFrom(ch, startSample + firstPart, output, ch, 0, numSamples - firstPart);
+    }
+    
+    outputStart = (outputStart + numSamples) % outputSize;
+    numOutput -= numSamples;
+}
+
+void EffectsPipeline::collect(int blockIndex)
+{
+    auto& block = blocks[(size_t) blockIndex];
+    const int outputSize = output.getNumSamples();
+    
+    jassert(numOutput + blockSize <= outputSize);
+    
+    const int writeStart = (outputStart + numOutput) % outputSize;
+    const int firstPart = juce::jmin(blockSize, outputSize - writeStart);
+    
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        output.copyFrom(ch, writeStart, block, ch, 0, firstPart);
+        
+        if (firstPart < blockSize)
+            output.copyFrom(ch, 0, block, ch, firstPart, blockSize - firstPart);
+    }
+    
+    numOutput += blockSize;
+}
+
+//==============================================================================
+EffectsPipeline::Worker::Worker(EffectsPipeline& owner)
+: juce::Thread("Sketchbook Effects"),
+  pipeline(owner)
+{
+}
+
+void EffectsPipeline::Worker::run()
+{
+    juce::ScopedNoDenormals noDenormals;
+    int numSpins = 0;
+    
+    while (!threadShouldExit())
+    {
+        if (pipeline.hasWork.exchange(false, std::memory_order_acq_rel))
+        {
+            {
+                RealtimeAuditor::ScopedRealtimeSection realtimeSection;
+                pipeline.processEffects(pipeline.blocks[(size_t) pipeline.workIndex]);
+            }
+            
+            pipeline.isBusy.store(false, std::memory_order_release);
+            numSpins = 0;
+        }
+        else if (++numSpins < numSpinsBeforeSleep)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            wait(100);
+            numSpins = 0;
+        }
+    }
+}
+    
+} //end namespace sketchbook
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    EffectsPipeline.h
+    Created: 16 Oct 2026 11:59:12pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ Runs an engine's effects on a second real-time thread, one block behind the
+ voices, so the cost of the effects no longer adds to the cost of the voices.
+ 
+ The voices' output is gathered into blocks of the prepared size. A block
+ that is complete at the start of a call is handed to the effects thread,
+ which processes it while the voices render the next one. The output is
+ delayed by exactly one prepared block, whatever size the calls are. When
+ the calls are the prepared size the two threads overlap fully. Smaller calls
+ sometimes have to process a block on the calling thread instead.
+ 
+ The effects thread is only ever busy inside process(), so everything else
+ the engine does between calls, applying parameter changes and publishing
+ telemetry, never races with it.
+ */
+class EffectsPipeline
+{
+    public:
+    
+    /** processes one block of effects, in place */
+    using ProcessEffects = std::function<void(juce::AudioBuffer<float>&)>;
+    
+    ~EffectsPipeline();
+    
+    /** sizes the blocks and starts the effects thread, allocates */
+    void prepare(int numChannels, int blockSize, ProcessEffects processEffects);
+    
+    /** stops the effects thread, the effects are then run in series by the engine */
+    void release();
+    
+    bool isActive() const
+    {
+        return worker != nullptr;
+    }
+    
+    /** the delay the pipeline adds, one block, or 0 when it is not active */
+    int getLatencyInSamples() const
+    {
+        return isActive() ? blockSize : 0;
+    }
+    
+    /**
+     Calls renderVoices(start, num) to render the voices into buffer, then
+     replaces those samples with the effects' output from one block earlier.
+     Calls longer than the prepared block are split into blocks
+     */
+    template <typename RenderVoices>
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, RenderVoices&& renderVoices)
+    {
+        while (numSamples > 0)
+        {
+            const int num = juce::jmin(numSamples, blockSize);
+            
+            startCompleteBlock();
+            renderVoices(startSample, num);
+            pushVoices(buffer, startSample, num);
+            finishBlocks(num);
+            pullOutput(buffer, startSample, num);
+            
+            startSample += num;
+            numSamples -= num;
+        }
+    }
+    
+    private:
+    
+    class Worker : public juce::Thread
+    {
+        public:
+        
+        explicit Worker(EffectsPipeline& owner);
+        
+        void run() override;
+        
+        private:
+        
+        EffectsPipeline& pipeline;
+    };
+    
+    //hands a block that was completed in an earlier call to the effects thread
+    void startCompleteBlock();
+    
+    //copies the voices' output into the block being filled
+    void pushVoices(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    
+    //waits for the effects thread, and processes any further block the output needs
+    void finishBlocks(int numSamplesNeeded);
+    
+    void pullOutput(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    
+    //moves a processed block onto the end of the output
+    void collect(int blockIndex);
+    
+    ProcessEffects processEffects;
+    std::unique_ptr<Worker> worker;
+    
+    int numChannels = 0;
+    int blockSize = 0;
+    
+    //a block being filled with voices, one that is complete and one with the effects thread
+    std::array<juce::AudioBuffer<float>, 3> blocks;
+    int fillingIndex = 0;
+    int numFilled = 0;
+    int completeIndex = -1;
+    int workIndex = -1;
+    
+    std::atomic<bool> hasWork { false };
+    std::atomic<bool> isBusy { false };
+    
+    //processed audio waiting to be output, a ring buffer
+    juce::AudioBuffer<float> output;
+    int outputStart = 0;
+    int numOutput = 0;
+    
+    //as VoiceThreadPool, the effects thread checks for work for a while before sleeping
+    static constexpr int numSpinsBeforeSleep = 512;
+};
+    
+} //end namespace sketchbook
@@ -4,6 +4,10 @@
 
 #include "Module.h"
 #include "Voices.h"
+#include "RealtimeAuditor.h"
+#include "ParameterQueue.h"
+#include "ModulationTelemetry.h"
+#include "EffectsPipeline.h"
 #include "../Modules/ModulationSources.h"
 #include "../Modules/EnvelopeModule.h"
 
@@ -37,9 +41,12 @@ static void assignInstanceIds(juce::Array<Module*> modules)
  template <typename... Ts>
  struct TypeList {};
  */
-template <typename VoiceModules, typename FxModules = ModuleList<>, typename ModulationSources = ModuleList<LfoModule, LfoModule, EnvelopeModule, EnvelopeModule>>
-class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationSources>
+//Polyphony is the number of voices, these are all allocated up front
+template <typename VoiceModules, typename FxModules = ModuleList<>, typename ModulationSources = ModuleList<LfoModule, LfoModule, EnvelopeModule, EnvelopeModule>, int Polyphony = 32>
+class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationSources, Polyphony>
 {
+    using VoiceControllerType = sketchbook::VoiceController<VoiceModules, ModulationSources, Polyphony>;
+    
     public:
     
     //==============================================================================
@@ -58,7 +65,7 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
         }
         
         //set the data in the voice controller to track "voice mode"
-        sketchbook::VoiceController<VoiceModules, ModulationSources>::setData(pluginData);
+        VoiceControllerType::setData(pluginData);
         
         //create a temporary voiceModules object in order to grab the module state data in the structure setup
         VoiceModules tmpVoiceModules;
@@ -68,26 +75,41 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
         tmpVoiceModules.forEach([&] (auto& mod, auto)
                                 {
             pluginData.getChildWithName(Module::ParamIdents::MODULES).addChild(mod.getModuleState(), -1, nullptr);
+            registerTelemetry(mod);
         });
         
         //do the same for modulation sources
         tmpModSources.forEach([&] (auto& mod, auto)
                               {
             pluginData.getChildWithName(Module::ParamIdents::MODULATION_SOURCES).addChild(mod.getModuleState(), -1, nullptr);
+            registerTelemetry(mod);
         });
         
         //setup individual voices
-        for (int i = 0; i < sketchbook::VoiceController<VoiceModules, ModulationSources>::getNumVoices(); i++)
+        for (int i = 0; i < VoiceControllerType::getNumVoices(); i++)
         {
-            if (auto v = sketchbook::VoiceController<VoiceModules, ModulationSources>::getVoice(i))
+            if (auto v = VoiceControllerType::getVoice(i))
                 v->setData(pluginData);
         }
         
         //setup fx parameter
         fxChain.forEach([&] (auto& mod, auto) {
             pluginData.getChildWithName(Module::ParamIdents::EFFECT_FILTERS).addChild(mod.getModuleState(), -1, nullptr);
+            registerTelemetry(mod);
+        });
+        
+        modulationTelemetry.allocate();
+        setupProfiler();
+        
+        //from here on parameter changes are applied at the start of each block
+        VoiceControllerType::setParameterQueue(&parameterQueue);
+        
+        fxChain.forEach([&] (auto& mod, auto) {
+            mod.setParameterQueue(&parameterQueue);
         });
         
+        parameterQueue.allocate();
+        
         //DBG(pluginData.toXmlString());
     }
     
@@ -97,14 +119,39 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
     }
     
     //==============================================================================
-    void prepare (float samplerate, int blockSize) noexcept override
+    void prepare (float samplerate, int blockSize, int numChannels = 2) noexcept override
     {
-        sketchbook::VoiceController<VoiceModules, ModulationSources>::prepare(samplerate, blockSize);
+        VoiceControllerType::prepare(samplerate, blockSize, numChannels);
         
         fxChain.forEach([&] (auto& mod, auto)
                         {
             mod.prepareToPlay(samplerate, blockSize);
+            mod.prepareEnableFade(samplerate, blockSize, numChannels);
+            mod.prepareSleep(samplerate);
         });
+        
+        updateTailLength();
+        
+        if (pipelineEffects)
+            effectsPipeline.prepare(numChannels, blockSize, [this] (juce::AudioBuffer<float>& block) { processEffects(block); });
+        else
+            effectsPipeline.release();
+    }
+    
+    /**
+     Runs the effects on a second real-time thread, a block behind the voices,
+     so their cost no longer adds to the voices'. The output is then delayed
+     by one block, which is included in getLatencyInSamples. Takes effect on
+     the next call to prepare, see EffectsPipeline
+     */
+    void setPipelinedEffects(bool shouldPipeline)
+    {
+        pipelineEffects = shouldPipeline;
+    }
+    
+    bool isPipeliningEffects() const
+    {
+        return effectsPipeline.isActive();
     }
     
     juce::ValueTree getPluginData()
@@ -112,12 +159,94 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
         return pluginData;
     }
     
+    /** a copy of the current state, to be saved, see setState */
+    juce::ValueTree getState()
+    {
+        return pluginData.createCopy();
+    }
+    
+    /**
+     Loads a state made by getState. The values are copied into the live state
+     rather than replacing it, so the modules are told about every change.
+     Modules and parameters missing from the saved state keep their values,
+     and the modulation mappings of every saved parameter are replaced
+     */
+    void setState(const juce::ValueTree& state)
+    {
+        for (auto& sectionId : { Module::ParamIdents::MODULES, Module::ParamIdents::MODULATION_SOURCES, Module::ParamIdents::EFFECT_FILTERS })
+        {
+            auto savedSection = state.getChildWithName(sectionId);
+            
+            for (auto module : pluginData.getChildWithName(sectionId))
+            {
+                auto savedModule = savedSection.getChildWithProperty(Module::ParamIdents::NAME, module[Module::ParamIdents::NAME]);
+                
+                if (!savedModule.isValid())
+                    continue;
+                
+                if (savedModule.hasProperty(Module::ParamIdents::ENABLED))
+                    module.setProperty(Module::ParamIdents::ENABLED, savedModule[Module::ParamIdents::ENABLED], nullptr);
+                
+                auto savedParameters = savedModule.getChildWithName(Module::ParamIdents::PARAMETERS);
+                
+                for (auto parameter : module.getChildWithName(Module::ParamIdents::PARAMETERS))
+                {
+                    auto savedParameter = savedParameters.getChildWithProperty(Module::ParamIdents::PARAMETER_NAME,
+                                                                               parameter[Module::ParamIdents::PARAMETER_NAME]);
+                    
+                    if (savedParameter.isValid())
+                        loadParameter(parameter, savedParameter);
+                }
+            }
+        }
+    }
+    
+    /**
+     The delay the engine adds, in samples. Voice modules are summed so the
+     slowest of them counts, the effects run in series so theirs add up, and
+     pipelined effects add a block
+     */
+    float getLatencyInSamples()
+    {
+        float voiceLatency = 0.f;
+        
+        if (auto* voice = VoiceControllerType::getVoice(0))
+            voice->forEachModule([&] (Module& mod) { voiceLatency = juce::jmax(voiceLatency, mod.getLatencyInSamples()); });
+        
+        float fxLatency = 0.f;
+        fxChain.forEach([&] (auto& mod, auto) { fxLatency += mod.getLatencyInSamples(); });
+        
+        return voiceLatency + fxLatency + (float) effectsPipeline.getLatencyInSamples();
+    }
+    
+    /**
+     How long the effects keep sounding once the voices stop, the sum of
+     their tails as they run in series. Kept up to date each block, and safe
+     to call from any thread
+     */
+    double getTailLengthSeconds() const
+    {
+        return tailLengthSeconds.load(std::memory_order_relaxed);
+    }
+    
+    /** the modulated parameter values of the latest voice and the effects, published once per block */
+    ModulationTelemetry& getModulationTelemetry()
+    {
+        return modulationTelemetry;
+    }
+    
+    /** the cycles spent in each module, see ModuleProfiler */
+    ModuleProfiler& getModuleProfiler()
+    {
+        return moduleProfiler;
+    }
+    
     /**
      Will search for a module by name - in the latest playing voice or in the fxChain
      */
     Module* getLatestPlayingModuleByName(juce::String name)
     {
-        if (auto v = sketchbook::VoiceController<VoiceModules, ModulationSources>::getLatestVoice())
+        if (auto v = VoiceControllerType::getLatestVoice())
         {
             for (auto mod : v->getModulesArray())
                 if (mod->getNameInternal() == name)
@@ -134,17 +263,53 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
     
     void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int numSamples) override
     {
-        sketchbook::VoiceController<VoiceModules, ModulationSources>::process(buffer, midiMessages, startSample, numSamples);
+        //nothing below this point may allocate
+        RealtimeAuditor::ScopedRealtimeSection realtimeSection;
+        ModuleProfiler::ScopedProbe probe(engineProfilerCounter);
+        
+        parameterQueue.applyPending();
         
+        if (effectsPipeline.isActive())
+        {
+            effectsPipeline.process(buffer, startSample, numSamples, [&] (int blockStart, int blockSize) {
+                VoiceControllerType::process(buffer, midiMessages, blockStart, blockSize);
+            });
+        }
+        else
+        {
+            VoiceControllerType::process(buffer, midiMessages, startSample, numSamples);
+            processEffects(buffer);
+        }
+        
+        publishTelemetry();
+    }
+    
+    private:
+    
+    //may run on the pipeline's thread, but never while the audio thread touches the effects
+    void processEffects(juce::AudioBuffer<float>& buffer)
+    {
         fxChain.forEach([&] (auto& mod, auto)
                         {
+            //effects that are switched off, or asleep after a silent input, are not touched at all
+            if (!mod.isModuleActive() || mod.canSleep(buffer))
+                return;
+            
+            ModuleProfiler::ScopedProbe moduleProbe(mod.getProfilerCounter());
             mod.runModulations();
-            if (mod.isModuleEnabled())
-                mod.process(buffer);
+            mod.processWithEnableFade(buffer);
+            mod.trackOutputLevel(buffer);
         });
+        
+        updateTailLength();
     }
     
-    private:
+    void updateTailLength()
+    {
+        double tail = 0.0;
+        fxChain.forEach([&] (auto& mod, auto) { tail += mod.getTailLengthSeconds(); });
+        tailLengthSeconds.store(tail, std::memory_order_relaxed);
+    }
     
     static juce::ValueTree getDefaultData()
     {
@@ -161,13 +326,49 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
         vcModule.removeProperty(Module::ParamIdents::ENABLED, nullptr);
         auto voiceMode = Module::Parameter::Choice("Voice Mode", [&] (juce::var) {}, {"Poly", "Mono", "Legato"}, "Poly");
         auto portaTime = Module::Parameter::Float("Porta Time",  [&] (juce::var) {}, 0.3f, 0.f, 1.f);
+        auto voiceSteal = Module::Parameter::Choice("Voice Steal", [&] (juce::var) {}, {"Oldest", "Quietest", "Released First", "Same Note"}, "Oldest");
+        auto polyphony = Module::Parameter::Integer("Polyphony", [&] (juce::var) {}, Polyphony, 1, Polyphony);
+        
+        //the share of each block that voice rendering may use before voices are shed, 0 is off
+        auto cpuBudget = Module::Parameter::Float("CPU Budget", [&] (juce::var) {}, 0.f, 0.f, 1.f);
+        
+        //samples between evaluations of the modulation sources
+        auto controlRate = Module::Parameter::Choice("Control Rate", [&] (juce::var) {}, {"16", "32", "64"}, "32");
+        
+        //where the voices sit in the stereo field
+        auto pan = Module::Parameter::Float("Pan", [&] (juce::var) {}, 0.f, -1.f, 1.f);
+        auto stereoSpread = Module::Parameter::Float("Stereo Spread", [&] (juce::var) {}, 0.f, 0.f, 1.f);
+        
+        //the shortest stretch that a note may split a block into
+        auto midiSplitSize = Module::Parameter::Choice("MIDI Split Size", [&] (juce::var) {}, {"1", "8", "16", "32", "64"}, "32");
+        
         vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(voiceMode->getValueTree(), -1, nullptr);
         vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(portaTime->getValueTree(), -1, nullptr);
+        vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(voiceSteal->getValueTree(), -1, nullptr);
+        vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(polyphony->getValueTree(), -1, nullptr);
+        vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(cpuBudget->getValueTree(), -1, nullptr);
+        vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(controlRate->getValueTree(), -1, nullptr);
+        vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(pan->getValueTree(), -1, nullptr);
+        vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(stereoSpread->getValueTree(), -1, nullptr);
+        vcModule.getChildWithName(Module::ParamIdents::PARAMETERS).addChild(midiSplitSize->getValueTree(), -1, nullptr);
         tree.getChildWithName(Module::ParamIdents::MODULES).addChild(vcModule, -1, nullptr);
         
         return tree;
     }
     
+    static void loadParameter(juce::ValueTree parameter, const juce::ValueTree& savedParameter)
+    {
+        parameter.setProperty(Module::ParamIdents::VALUE, savedParameter[Module::ParamIdents::VALUE], nullptr);
+        
+        for (int i = parameter.getNumChildren(); --i >= 0;)
+            if (parameter.getChild(i).hasType(Module::ParamIdents::MODULATION))
+                parameter.removeChild(i, nullptr);
+        
+        for (auto mapping : savedParameter)
+            if (mapping.hasType(Module::ParamIdents::MODULATION))
+                parameter.appendChild(mapping.createCopy(), nullptr);
+    }
+    
     //set instance ids for repeated instances of a class
     static void setInstanceIdsForAll(VoiceModules& voiceMods, ModulationSources& modSources, FxModules& fxModules)
     {
@@ -177,6 +378,64 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
     }
     
     
+    void registerTelemetry(Module& mod)
+    {
+        for (auto& paramName : mod.getModifiedParamNames())
+            modulationTelemetry.addParameter(mod.getNameInternal(), paramName);
+    }
+    
+    //every module is counted by name, whichever voice it is in
+    void setupProfiler()
+    {
+        moduleProfiler.addProbe(ModuleProfiler::engineProbeName);
+        moduleProfiler.addProbe(ModuleProfiler::modulationProbeName);
+        
+        if (auto* voice = VoiceControllerType::getVoice(0))
+        {
+            voice->forEachModule([&] (Module& mod) { moduleProfiler.addProbe(mod.getNameInternal()); });
+            moduleProfiler.addProbe(voice->getVoiceADSR()->getNameInternal());
+        }
+        
+        fxChain.forEach([&] (auto& mod, auto) { moduleProfiler.addProbe(mod.getNameInternal()); });
+        
+        moduleProfiler.allocate();
+        
+        VoiceControllerType::setProfiler(moduleProfiler);
+        
+        fxChain.forEach([&] (auto& mod, auto)
+        {
+            mod.setProfilerCounter(moduleProfiler.getCounter(moduleProfiler.getProbeId(mod.getNameInternal())));
+        });
+        
+        engineProfilerCounter = moduleProfiler.getCounter(moduleProfiler.getProbeId(ModuleProfiler::engineProbeName));
+    }
+    
+    //written in the order the parameters were registered
+    void publishTelemetry()
+    {
+        if (modulationTelemetry.getNumParameters() == 0)
+            return;
+        
+        float* values = modulationTelemetry.getWriteBuffer();
+        
+        auto* voice = VoiceControllerType::getLatestVoice();
+        
+        if (voice == nullptr)
+            voice = VoiceControllerType::getVoice(0);
+        
+        voice->forEachModule([&] (Module& mod)
+        {
+            values += mod.getModulatedValues(values);
+        });
+        
+        fxChain.forEach([&] (auto& mod, auto)
+        {
+            values += mod.getModulatedValues(values);
+        });
+        
+        modulationTelemetry.publish();
+    }
+    
     /// Runs through modules and checks if any are marked as requiring
     ///  an adsr envelope
     bool isVoiceEnvelopeNeeded()
@@ -194,6 +453,21 @@ class AudioEngine : public sketchbook::VoiceController<VoiceModules, ModulationS
     private:
     juce::ValueTree pluginData;
     FxModules fxChain;
+    
+    //changes made on the message thread, waiting for the next block
+    ParameterQueue parameterQueue;
+    
+    ModulationTelemetry modulationTelemetry;
+    
+    ModuleProfiler moduleProfiler;
+    ModuleProfiler::Counter* engineProfilerCounter = nullptr;
+    
+    //declared after fxChain, so its thread has stopped before the effects go
+    bool pipelineEffects = false;
+    EffectsPipeline effectsPipeline;
+    
+    //written by whichever thread runs the effects, see getTailLengthSeconds
+    std::atomic<double> tailLengthSeconds { 0.0 };
 };
 
 //==============================================================================
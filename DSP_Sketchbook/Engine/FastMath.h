@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+    Created: 16 Oct 2026 11:59:58pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cstring>
+
+namespace sketchbook
+{
+
+/**
+ Cheap stand ins for the libm functions on the hot paths, each with three
+ accuracy tiers. The worst errors against libm, as checked by the benchmarks'
+ --fast-math option, are about
+                 
+                 low         medium      high
+     sin2Pi      8e-5        1e-6        2.5e-7      absolute
+     tanh        2.5e-2      1.2e-4      2e-7        absolute
+     exp2        2e-4        3e-7        1.5e-7      relative
+     log2        1.2e-5      4e-7        4e-7        absolute, over [1/64, 64]
+ 
+ where the high tier is limited by float rounding, and does better in double.
+ The polynomial cores are templates, so the same coefficients serve floats,
+ doubles and SIMD registers, see VoiceLanes::sin2Pi
+ */
+namespace FastMath
+{
+
+enum class Accuracy
+{
+    low = 0, medium, high
+};
+
+/** evaluates a polynomial in x by Horner's method, the coefficients are given highest power first */
+template <typename T, typename Coefficient, size_t N>
+constexpr T polynomial(T x, const std::array<Coefficient, N>& highestFirst)
+{
+    static_assert(N >= 2, "use a constant");
+    
+    T result = x * highestFirst[0] + highestFirst[1];
+    
+    for (size_t i = 2; i < N; i++)
+        result = result * x + highestFirst[i];
+    
+    return result;
+}
+
+//==============================================================================
+/**
+ sin(2 pi x) for x in [-0.25, 0.25], an odd polynomial fitted for the least
+ worst case error. Works on anything with + and *, including SIMD registers
+ */
+template <Accuracy accuracy, typename T>
+constexpr T sin2PiQuarter(T x)
+{
+    const T x2 = x * x;
+    
+    if constexpr (accuracy == Accuracy::low)
+        return x * polynomial(x2, std::array<float, 3> { 73.5859370f, -41.0952785f, 6.28128074f });
+    else if constexpr (accuracy == Accuracy::medium)
+        return x * polynomial(x2, std::array<float, 4> { -70.9937033f, 81.3408005f, -41.3371435f, 6.28316405f });
+    else
+        return x * polynomial(x2, std::array<float, 5> { 39.5368967f, -76.5498103f, 81.6010055f, -41.3416551f, 6.28318516f });
+}
+
+/** sin(2 pi x), for any x that fits in an int */
+template <Accuracy accuracy = Accuracy::high, typename T>
+constexpr T sin2Pi(T x)
+{
+    //into [0, 1)
+    x = x - T(int(x));
+    
+    if (x < T(0))
+        x = x + T(1);
+    
+    //then [-0.5, 0.5), then folded into a quarter cycle
+    if (x >= T(0.5))
+        x = x - T(1);
+    
+    if (x > T(0.25))
+        x = T(0.5) - x;
+    else if (x < T(-0.25))
+        x = T(-0.5) - x;
+    
+    return sin2PiQuarter<accuracy>(x);
+}
+
+/** sin(x), x in radians */
+template <Accuracy accuracy = Accuracy::high, typename T>
+constexpr T sin(T x)
+{
+    return sin2Pi<accuracy>(x * T(1.0 / juce::MathConstants<double>::twoPi));
+}
+
+//==============================================================================
+/** 2^x, for x that keeps the result a normal number */
+template <Accuracy accuracy = Accuracy::high, typename T>
+inline T exp2(T x)
+{
+    static_assert(std::is_floating_point_v<T>, "exp2 is only implemented for float and double");
+    
+    //2^x = 2^i * 2^f, with f in [-0.5, 0.5], so that 2^f - 1 keeps its relative accuracy near 0
+    const T rounded = x < T(0) ? T(int(x - T(0.5))) : T(int(x + T(0.5)));
+    const T f = x - rounded;
+    
+    T fraction;
+    
+    if constexpr (accuracy == Accuracy::low)
+        fraction = T(1) + f * polynomial(f, std::array<T, 3> { T(0.0555036065), T(0.242028846), T(0.693178348) });
+    else if constexpr (accuracy == Accuracy::medium)
+        fraction = T(1) + f * polynomial(f, std::array<T, 5> { T(0.00133334979), T(0.00966624528), T(0.0555050032),
+                                                                T(0.240223513), T(0.693147143) });
+    else
+        fraction = T(1) + f * polynomial(f, std::array<T, 6> { T(0.000154034782), T(0.00133907354), T(0.00961823760),
+                                                                T(0.0555035743), T(0.240226498), T(0.693147188) });
+    
+    //put the whole part straight into the exponent bits
+    if constexpr (std::is_same_v<T, float>)
+    {
+        const auto bits = juce::uint32(int(rounded) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return fraction * scale;
+    }
+    else
+    {
+        const auto bits = juce::uint64(juce::int64(rounded) + 1023) << 52;
+        double scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return fraction * scale;
+    }
+}
+
+/** log2(x), for positive normal x */
+template <Accuracy accuracy = Accuracy::high, typename T>
+inline T log2(T x)
+{
+    static_assert(std::is_floating_point_v<T>, "log2 is only implemented for float and double");
+    jassert(x > T(0));
+    
+    //split x into 2^e * m, with m in [1, 2)
+    int exponent;
+    T mantissa;
+    
+    if constexpr (std::is_same_v<T, float>)
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        exponent = int((bits >> 23) & 0xff) - 127;
+        bits = (bits & 0x007fffff) | 0x3f800000;
+        std::memcpy(&mantissa, &bits, sizeof(bits));
+    }
+    else
+    {
+        juce::uint64 bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        exponent = int((bits >> 52) & 0x7ff) - 1023;
+        bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+        std::memcpy(&mantissa, &bits, sizeof(bits));
+    }
+    
+    //then centre m on 1, in [sqrt(1/2), sqrt(2))
+    if (mantissa > T(1.41421356237))
+    {
+        mantissa = mantissa * T(0.5);
+        exponent++;
+    }
+    
+    //log2(m) = t R(t^2) with t = (m - 1) / (m + 1), which stays small
+    const T t = (mantissa - T(1)) / (mantissa + T(1));
+    const T t2 = t * t;
+    T logMantissa;
+    
+    if constexpr (accuracy == Accuracy::low)
+        logMantissa = t * polynomial(t2, std::array<T, 2> { T(0.979099508), T(2.88532649) });
+    else if constexpr (accuracy == Accuracy::medium)
+        logMantissa = t * polynomial(t2, std::array<T, 3> { T(0.595766253), T(0.961588854), T(2.88539042) });
+    else
+        logMantissa = t * polynomial(t2, std::array<T, 4> { T(0.431726469), T(0.576714865), T(0.961798841), T(2.88539008) });
+    
+    return T(exponent) + logMantissa;
+}
+
+/** base^exponent, for a positive base */
+template <Accuracy accuracy = Accuracy::high, typename T>
+inline T pow(T base, T exponent)
+{
+    return exp2<accuracy>(exponent * log2<accuracy>(base));
+}
+
+//==============================================================================
+/** tanh(x). Low and medium are clamped rational fits, high is worked out from exp2 */
+template <Accuracy accuracy = Accuracy::medium, typename T>
+inline T tanh(T x)
+{
+    if constexpr (accuracy == Accuracy::low)
+    {
+        x = juce::jlimit(T(-3), T(3), x);
+        const T x2 = x * x;
+        return x * (T(27) + x2) / (T(27) + T(9) * x2);
+    }
+    else if constexpr (accuracy == Accuracy::medium)
+    {
+        x = juce::jlimit(T(-4.97), T(4.97), x);
+        const T x2 = x * x;
+        return x * polynomial(x2, std::array<T, 4> { T(1), T(378), T(17325), T(135135) })
+                 / polynomial(x2, std::array<T, 4> { T(28), T(3150), T(62370), T(135135) });
+    }
+    else
+    {
+        //past 9 tanh is 1 to float precision
+        x = juce::jlimit(T(-9), T(9), x);
+        //e^2x, as 2^(2x log2(e))
+        const T e = exp2<Accuracy::high>(x * T(2.88539008177792681));
+        return (e - T(1)) / (e + T(1));
+    }
+}
+    
+} //end namespace FastMath
+} //end namespace sketchbook
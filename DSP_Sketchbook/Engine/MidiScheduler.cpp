@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    MidiScheduler.cpp
+    Created: 16 Oct 2026 9:14:02pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "MidiScheduler.h"
+
+namespace sketchbook
+{
+
+void MidiScheduler::setMinimumSubBlockSize(int numSamples)
+{
+    minimumSubBlockSize = juce::jmax(1, numSamples);
+}
+
+bool MidiScheduler::addPending(const juce::MidiMessageMetadata& event)
+{
+    const int key = getCoalescingKey(event);
+    
+    if (key >= 0 && keyRun[(size_t) key] == currentRun)
+    {
+        pending[(size_t) keyIndex[(size_t) key]] = event;
+        return true;
+    }
+    
+    if (numPending == maxPendingEvents)
+        return false;
+    
+    if (key >= 0)
+    {
+        keyRun[(size_t) key] = currentRun;
+        keyIndex[(size_t) key] = numPending;
+    }
+    else if (isNoteEvent(event))
+    {
+        //changes either side of a note are kept apart
+        currentRun++;
+    }
+    
+    pending[(size_t) numPending++] = event;
+    return true;
+}
+
+bool MidiScheduler::isNoteEvent(const juce::MidiMessageMetadata& event)
+{
+    if (event.numBytes < 3)
+        return false;
+    
+    const auto type = event.data[0] & 0xf0;
+    return type == 0x80 || type == 0x90;
+}
+
+int MidiScheduler::getCoalescingKey(const juce::MidiMessageMetadata& event)
+{
+    if (event.numBytes < 2)
+        return -1;
+    
+    const int type = event.data[0] & 0xf0;
+    const int channel = event.data[0] & 0x0f;
+    
+    switch (type)
+    {
+        case 0xb0:
+        {
+            if (event.numBytes < 3)
+                return -1;
+            
+            const int controller = event.data[1];
+            
+            //data entry and parameter numbers only make sense in sequence
+            const bool isRegisteredParameter = controller == 6 || controller == 38 || (controller >= 96 && controller <= 101);
+            
+            if (isRegisteredParameter || controller >= 120)
+                return -1;
+            
+            return channel * 128 + controller;
+        }
+        
+        case 0xa0:
+            return event.numBytes < 3 ? -1 : numChannels * 128 + channel * 128 + event.data[1];
+        
+        case 0xe0:
+            return numChannels * 256 + channel;
+        
+        case 0xd0:
+            return numChannels * 256 + numChannels + channel;
+        
+        case 0xc0:
+            return numChannels * 256 + numChannels * 2 + channel;
+        
+        default:
+            return -1;
+    }
+}
+    
+} //end namespace sketchbook
@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    MidiScheduler.h
+    Created: 16 Oct 2026 9:14:02pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ Decides where a block is split for the midi that arrives in it.
+ 
+ Only note ons and offs split the block, and then only if the sub block
+ before them would be at least the minimum sub block size, otherwise they
+ are applied early at the start of that sub block. Every other message
+ (controllers, pitch bend, pressure...) is applied at the start of the sub
+ block it falls in, so a dense controller stream never causes extra splits.
+ 
+ Events waiting for the same sub block are coalesced. A controller, pitch
+ bend, pressure or program change replaces an earlier one of the same kind
+ and channel, as long as no note event lies between them. RPN and NRPN
+ controllers and channel mode messages are order dependent and are always
+ passed on as they are.
+ 
+ juce::MidiBuffer keeps its events in time order, so they are grouped in a
+ single pass and nothing allocates.
+ */
+class MidiScheduler
+{
+    public:
+    
+    /** the most events that are held back for one sub block before being passed on early */
+    static constexpr int maxPendingEvents = 256;
+    
+    /** the shortest sub block that a note event may split off, the first split of a block may be shorter */
+    void setMinimumSubBlockSize(int numSamples);
+    
+    int getMinimumSubBlockSize() const
+    {
+        return minimumSubBlockSize;
+    }
+    
+    /**
+     Runs through the midi in [startSample, startSample + numSamples), calling
+     handleEvent(const juce::MidiMessage&) for each event that is passed on, and
+     renderSubBlock(int start, int numSamples) for each stretch of the block
+     */
+    template <typename HandleEvent, typename RenderSubBlock>
+    void process(const juce::MidiBuffer& midi, int startSample, int numSamples,
+                 HandleEvent&& handleEvent, RenderSubBlock&& renderSubBlock)
+    {
+        const int endSample = startSample + numSamples;
+        const int minSize = minimumSubBlockSize;
+        int subBlockStart = startSample;
+        
+        for (auto it = midi.findNextSamplePosition(startSample); it != midi.cend(); ++it)
+        {
+            const auto event = *it;
+            
+            if (event.samplePosition >= endSample)
+                break;
+            
+            if (isNoteEvent(event))
+            {
+                //a note right at the start of the block may split off a single sample
+                const int minSizeHere = subBlockStart == startSample ? 1 : minSize;
+                
+                if (event.samplePosition >= subBlockStart + minSizeHere)
+                {
+                    passOnPending(handleEvent);
+                    renderSubBlock(subBlockStart, event.samplePosition - subBlockStart);
+                    subBlockStart = event.samplePosition;
+                }
+            }
+            
+            if (!addPending(event))
+            {
+                //full, what is waiting belongs at the start of this sub block anyway
+                passOnPending(handleEvent);
+                addPending(event);
+            }
+        }
+        
+        passOnPending(handleEvent);
+        
+        if (subBlockStart < endSample)
+            renderSubBlock(subBlockStart, endSample - subBlockStart);
+    }
+    
+    private:
+    
+    template <typename HandleEvent>
+    void passOnPending(HandleEvent& handleEvent)
+    {
+        for (int i = 0; i < numPending; i++)
+            handleEvent(pending[(size_t) i].getMessage());
+        
+        numPending = 0;
+        currentRun++;
+    }
+    
+    //returns false if there is no room
+    bool addPending(const juce::MidiMessageMetadata& event);
+    
+    static bool isNoteEvent(const juce::MidiMessageMetadata& event);
+    
+    //events with the same key replace each other, -1 for events that are never coalesced
+    static int getCoalescingKey(const juce::MidiMessageMetadata& event);
+    
+    static constexpr int numChannels = 16;
+    static constexpr int numKeys = numChannels * 128 * 2 + numChannels * 3;
+    
+    std::atomic<int> minimumSubBlockSize { 32 };
+    
+    std::array<juce::MidiMessageMetadata, (size_t) maxPendingEvents> pending;
+    int numPending = 0;
+    
+    //where each key was last added, valid while its run matches the current one
+    std::array<int, (size_t) numKeys> keyIndex {};
+    std::array<juce::uint32, (size_t) numKeys> keyRun {};
+    juce::uint32 currentRun = 1;
+};
+    
+} //end namespace sketchbook
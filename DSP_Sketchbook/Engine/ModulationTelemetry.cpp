@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    ModulationTelemetry.cpp
+    Created: 16 Oct 2026 9:58:36pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "ModulationTelemetry.h"
+
+namespace sketchbook
+{
+
+int ModulationTelemetry::addParameter(const juce::String& moduleName, const juce::String& parameterName)
+{
+    //must be registered before the snapshots are sized
+    jassert(snapshots[0].empty());
+    
+    names.add(getKey(moduleName, parameterName));
+    return names.size() - 1;
+}
+
+int ModulationTelemetry::getParameterId(const juce::String& moduleName, const juce::String& parameterName) const
+{
+    return names.indexOf(getKey(moduleName, parameterName));
+}
+
+void ModulationTelemetry::allocate()
+{
+    for (auto& snapshot : snapshots)
+        snapshot.assign((size_t) names.size(), 0.f);
+}
+
+void ModulationTelemetry::publish()
+{
+    backIndex = middleIndex.exchange(backIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+}
+
+float ModulationTelemetry::getValue(int parameterId)
+{
+    if (!juce::isPositiveAndBelow(parameterId, names.size()) || snapshots[0].empty())
+        return 0.f;
+    
+    //take the newest snapshot if there is one the reader has not seen
+    if ((middleIndex.load(std::memory_order_relaxed) & freshFlag) != 0)
+        frontIndex = middleIndex.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+    
+    return snapshots[(size_t) frontIndex][(size_t) parameterId];
+}
+
+juce::String ModulationTelemetry::getKey(const juce::String& moduleName, const juce::String& parameterName)
+{
+    return moduleName + "/" + parameterName;
+}
+    
+} //end namespace sketchbook
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    ModulationTelemetry.h
+    Created: 16 Oct 2026 9:58:36pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ Hands the latest modulated parameter values from the audio thread to the UI.
+ 
+ Parameters are registered by module and parameter name while the engine is
+ built, and each is given an id. Once per block the audio thread fills in a
+ snapshot of every value and publishes it, the UI reads values by id. The
+ snapshots are kept in a triple buffer, so neither side ever waits for the
+ other and the reader always sees a whole block's worth of values.
+ 
+ There may be one writer thread and one reader thread, normally the audio
+ and message threads.
+ */
+class ModulationTelemetry
+{
+    public:
+    
+    /** registers a parameter and returns its id, not to be called once allocated */
+    int addParameter(const juce::String& moduleName, const juce::String& parameterName);
+    
+    /** the id of a registered parameter, or -1. Look this up once rather than per frame */
+    int getParameterId(const juce::String& moduleName, const juce::String& parameterName) const;
+    
+    int getNumParameters() const
+    {
+        return names.size();
+    }
+    
+    /** sizes the snapshots once every parameter is registered, allocates */
+    void allocate();
+
+    //==============================================================================
+    /** the snapshot to fill on the audio thread, indexed by parameter id */
+    float* getWriteBuffer()
+    {
+        return snapshots[(size_t) backIndex].data();
+    }
+    
+    /** hands the snapshot that was just filled over to the reader */
+    void publish();
+
+    //==============================================================================
+    /** the latest published value of a parameter, called from the reader thread */
+    float getValue(int parameterId);
+    
+    private:
+    
+    static juce::String getKey(const juce::String& moduleName, const juce::String& parameterName);
+    
+    juce::StringArray names;
+    
+    //the middle index is shared, the flag is set while it holds a snapshot the reader has not taken
+    static constexpr int freshFlag = 4;
+    static constexpr int indexMask = 3;
+    
+    std::array<std::vector<float>, 3> snapshots;
+    int backIndex = 0;
+    int frontIndex = 2;
+    std::atomic<int> middleIndex { 1 };
+};
+    
+} //end namespace sketchbook
@@ -115,8 +115,13 @@ Module::ParameterInternal::ParameterInternal(juce::String name, std::function<vo
     if (data.isValid())
         data.addListener(this);
     
+    minValue = _min;
+    maxValue = _max;
+    valueCallback = callback;
+    
     //send an initial value to the callback
     setValue(data[Module::ParamIdents::VALUE]);
+    currentValue = toNumber(getValue());
     paramChangedCallback(getValue());
 }
 
@@ -136,8 +141,13 @@ Module::ParameterInternal::ParameterInternal(String name, std::function<void(int
     if (data.isValid())
         data.addListener(this);
     
+    minValue = float(_min);
+    maxValue = float(_max);
+    valueCallback = [callback] (float value) { callback(juce::roundToInt(value)); };
+    
     //send an initial value to the callback
     setValue(data[Module::ParamIdents::VALUE]);
+    currentValue = toNumber(getValue());
     paramChangedCallback(getValue());
 }
 
@@ -154,8 +164,11 @@ Module::ParameterInternal::ParameterInternal(String name, std::function<void(boo
     if (data.isValid())
         data.addListener(this);
     
+    valueCallback = [callback] (float value) { callback(value > 0.5f); };
+    
     //send an initial value to the callback
     setValue(data[Module::ParamIdents::VALUE]);
+    currentValue = toNumber(getValue());
     paramChangedCallback(getValue());
 }
 
@@ -173,12 +186,68 @@ Module::ParameterInternal::ParameterInternal(String name, std::function<void(juc
     if (data.isValid())
         data.addListener(this);
     
+    this->options = options;
+    valueCallback = [this, callback] (float value) { callback(this->options[juce::roundToInt(value)]); };
+    
     //send an initial value to the callback
     setValue(data[Module::ParamIdents::VALUE]);
+    currentValue = toNumber(getValue());
     paramChangedCallback(getValue());
 }
 
 
+//schema parameter
+Module::ParameterInternal::ParameterInternal(const ParameterSpec& spec, std::atomic<float>& _storage)
+: paramName(juce::String(spec.name.data(), spec.name.size()))
+, storage(&_storage)
+{
+    minValue = spec.minValue;
+    maxValue = spec.maxValue;
+    
+    switch (spec.type)
+    {
+        case ParameterSpec::Type::floatParam:
+            parameterValue = spec.defaultValue;
+            min = spec.minValue;
+            max = spec.maxValue;
+            data = ValueTree(ParamIdents::PARAMETER_FLOAT)
+                .setProperty(ParamIdents::MIN, min, nullptr)
+                .setProperty(ParamIdents::MAX, max, nullptr);
+            break;
+            
+        case ParameterSpec::Type::intParam:
+            parameterValue = juce::roundToInt(spec.defaultValue);
+            min = juce::roundToInt(spec.minValue);
+            max = juce::roundToInt(spec.maxValue);
+            data = ValueTree(ParamIdents::PARAMETER_INTEGER)
+                .setProperty(ParamIdents::MIN, min, nullptr)
+                .setProperty(ParamIdents::MAX, max, nullptr);
+            break;
+            
+        case ParameterSpec::Type::boolParam:
+            parameterValue = spec.defaultValue > 0.5f;
+            data = ValueTree(ParamIdents::PARAMETER_BOOL);
+            break;
+            
+        case ParameterSpec::Type::choiceParam:
+            options = StringArray::fromTokens(juce::String(spec.options.data(), spec.options.size()), ";", "");
+            parameterValue = options[juce::roundToInt(spec.defaultValue)];
+            data = ValueTree(ParamIdents::PARAMETER_CHOICE)
+                .setProperty(ParamIdents::PARAMETER_OPTIONS, options.joinIntoString(";"), nullptr);
+            break;
+    }
+    
+    data.setProperty(ParamIdents::PARAMETER_NAME, paramName, nullptr)
+        .setProperty(ParamIdents::VALUE, parameterValue, nullptr);
+    
+    data.addListener(this);
+    
+    paramChangedCallback = [this] (juce::var value) { sendValue(toNumber(value)); };
+    
+    currentValue = toNumber(parameterValue);
+    storage->store(currentValue, std::memory_order_relaxed);
+}
+
 Module::ParameterInternal::~ParameterInternal()
 {
     data.removeListener(this);
@@ -204,10 +273,48 @@ void Module::ParameterInternal::valueTreePropertyChanged(ValueTree &treeWhosePro
     if (property == ParamIdents::VALUE)
     {
         parameterValue = treeWhosePropertyHasChanged[ParamIdents::VALUE];
+        valueSlot.post(toNumber(parameterValue));
+    }
+}
+
+float Module::ParameterInternal::toNumber(const var& value)
+{
+    if (options.size() > 0)
+    {
+        //an unknown choice keeps the last known one, so the audio thread never sees -1
+        const int index = options.indexOf(value.toString());
+        
+        if (index >= 0)
+            lastChoiceIndex = float(index);
         
-        if (paramChangedCallback)
-            paramChangedCallback(parameterValue);
+        return lastChoiceIndex;
     }
+    
+    return float(value);
+}
+
+void Module::ParameterInternal::applyValue(float value)
+{
+    currentValue = value;
+    sendValue(value);
+}
+
+void Module::ParameterInternal::sendValue(float value)
+{
+    if (storage != nullptr)
+        storage->store(value, std::memory_order_relaxed);
+    else if (valueCallback)
+        valueCallback(value);
+}
+
+float Module::ParameterInternal::getCurrentValue()
+{
+    return currentValue;
+}
+
+void Module::ParameterInternal::setParameterQueue(ParameterQueue* queue)
+{
+    valueSlot.setQueue(queue);
 }
 
 ValueTree Module::ParameterInternal::getValueTree()
@@ -226,91 +333,237 @@ void Module::ParameterInternal::setValueTree(ValueTree newData)
 
 float Module::ParameterInternal::getMinValue()
 {
-    return min;
+    return minValue;
 }
 
 float Module::ParameterInternal::getMaxValue()
 {
-    return max;
+    return maxValue;
 }
 
 float Module::ParameterInternal::getRange()
 {
-    return float(max) - float(min);
+    return maxValue - minValue;
 }
 
-Module::ModifiedParameter::Mapping::Mapping(ValueTree _data,
-                                            Module* _sourceModule)
+Module::ModifiedParameter::Mapping::Mapping(ValueTree _data, Module* _sourceModule, PendingMapping& _pending)
 : data(_data)
 , sourceModule(_sourceModule)
+, pending(_pending)
 {
     jassert(data.isValid());
     data.addListener(this);
 }
 
-Module::ModifiedParameter::Mapping::Mapping(const Module::ModifiedParameter::Mapping& other)
-: data(other.data)
-, sourceModule(other.sourceModule)
-, amount(other.amount)
-, centred(other.centred)
-, reversed(other.reversed)
-{
-    data.addListener(this);
-}
-
 Module::ModifiedParameter::Mapping::~Mapping()
 {
     if (data.isValid())
         data.removeListener(this);
 }
 
-void Module::ModifiedParameter::Mapping::valueTreePropertyChanged(ValueTree &treeWhosePropertyHasChanged, const Identifier &property)
+void Module::ModifiedParameter::Mapping::post()
 {
-    if (property == ParamIdents::MOD_AMOUNT)
-    {
-        amount = float(treeWhosePropertyHasChanged[ParamIdents::MOD_AMOUNT]);
-    }
-    else if (property == ParamIdents::MOD_CENTRED)
-    {
-        centred = bool(treeWhosePropertyHasChanged[ParamIdents::MOD_CENTRED]);
-    }
-    else if (property == ParamIdents::MOD_REVERSED)
-    {
-        reversed = bool(treeWhosePropertyHasChanged[ParamIdents::MOD_REVERSED]);
-    }
+    pending.amount.store(float(data.getProperty(ParamIdents::MOD_AMOUNT, 1.f)), std::memory_order_relaxed);
+    pending.centred.store(bool(data.getProperty(ParamIdents::MOD_CENTRED, false)), std::memory_order_relaxed);
+    pending.reversed.store(bool(data.getProperty(ParamIdents::MOD_REVERSED, false)), std::memory_order_relaxed);
+    pending.sourceModule.store(sourceModule, std::memory_order_relaxed);
+    
+    //the slot's own value is not used, posting it is what queues the entry
+    pending.slot.post(0.f);
+}
+
+void Module::ModifiedParameter::Mapping::valueTreePropertyChanged(ValueTree&, const Identifier &property)
+{
+    if (property == ParamIdents::MOD_AMOUNT || property == ParamIdents::MOD_CENTRED || property == ParamIdents::MOD_REVERSED)
+        post();
 }
 
 Module::ModifiedParameter::ModifiedParameter(std::shared_ptr<ParameterInternal> _parameter)
 : parameter(_parameter)
 {
     parameterName = parameter->getName();
+    
+    for (int i = 0; i < maxMappings; i++)
+        pendingMappings.add(new PendingMapping([this, i] (float) { applyMapping(i); }));
 }
 
 void Module::ModifiedParameter::addMapping(ValueTree data, Module* source)
 {
-    currMappings.add(Mapping(data, source));
+    //the first entry that no mapping is using, an entry being emptied can be reused
+    //straight away as only the latest values reach the audio thread
+    for (auto* pending : pendingMappings)
+    {
+        const bool isInUse = std::any_of(currMappings.begin(), currMappings.end(),
+                                         [pending] (Mapping* mapping) { return &mapping->pending == pending; });
+        
+        if (!isInUse)
+        {
+            currMappings.add(new Mapping(data, source, *pending))->post();
+            return;
+        }
+    }
     
-    if (currMappings.size() == 1 && onModulationBeginOrEnd)
-        onModulationBeginOrEnd(true);
+    //more mappings than maxMappings
+    jassertfalse;
 }
 
 void Module::ModifiedParameter::removeMapping(ValueTree data)
 {
-    currMappings.removeIf([data] (Mapping& map) {
-        return map.data == data;
-    });
+    for (int i = currMappings.size(); --i >= 0;)
+    {
+        auto* mapping = currMappings.getUnchecked(i);
+        
+        if (mapping->data == data)
+        {
+            mapping->pending.sourceModule.store(nullptr, std::memory_order_relaxed);
+            mapping->pending.slot.post(0.f);
+            currMappings.remove(i);
+        }
+    }
+}
+
+void Module::ModifiedParameter::setParameterQueue(ParameterQueue* queue)
+{
+    for (auto* pending : pendingMappings)
+        pending->slot.setQueue(queue);
+}
+
+void Module::ModifiedParameter::applyMapping(int index)
+{
+    const auto& pending = *pendingMappings.getUnchecked(index);
+    auto& mapping = mappings[(size_t) index];
+    const bool wasMapped = mapping.sourceModule != nullptr;
     
-    if (currMappings.size() == 0 && onModulationBeginOrEnd)
-        onModulationBeginOrEnd(false);
+    mapping.sourceModule = pending.sourceModule.load(std::memory_order_relaxed);
+    mapping.amount       = pending.amount.load(std::memory_order_relaxed);
+    mapping.centred      = pending.centred.load(std::memory_order_relaxed);
+    mapping.reversed     = pending.reversed.load(std::memory_order_relaxed);
+    
+    const bool isMapped = mapping.sourceModule != nullptr;
+    
+    if (isMapped == wasMapped)
+        return;
+    
+    numMappings += isMapped ? 1 : -1;
+    
+    if (onModulationBeginOrEnd && numMappings == (isMapped ? 1 : 0))
+        onModulationBeginOrEnd(isMapped);
 }
 
 void Module::ModifiedParameter::calculateAndSendModulation()
+{
+    isModulationBufferFilled = false;
+    rampStart = rampEnd = modulatedValue = calculateModulatedValue();
+    chunkRamp = { modulatedValue, modulatedValue };
+    parameter->sendValue(modulatedValue);
+}
+
+void Module::ModifiedParameter::setTargetFromSources(bool jumpToTarget, int sampleIndex)
+{
+    const float target = calculateModulatedValue(sampleIndex);
+    
+    rampStart = jumpToTarget ? target : rampEnd;
+    rampEnd = target;
+}
+
+void Module::ModifiedParameter::sendInterpolatedModulation(float startOfChunk, float endOfChunk)
+{
+    auto valueAt = [this] (float proportionOfTick)
+    {
+        return rampStart + (rampEnd - rampStart) * juce::jlimit(0.f, 1.f, proportionOfTick);
+    };
+    
+    isModulationBufferFilled = false;
+    chunkRamp = { valueAt(startOfChunk), valueAt(endOfChunk) };
+    modulatedValue = valueAt(0.5f * (startOfChunk + endOfChunk));
+    parameter->sendValue(modulatedValue);
+}
+
+BlockRamp Module::ModifiedParameter::getModulationRamp() const
+{
+    return chunkRamp;
+}
+
+void Module::ModifiedParameter::setAudioRate(bool shouldBeAudioRate)
+{
+    isAudioRate = shouldBeAudioRate;
+}
+
+bool Module::ModifiedParameter::isAudioRateModulated()
+{
+    return isAudioRate;
+}
+
+void Module::ModifiedParameter::prepareModulationBuffer(int bufferSize)
+{
+    if (isAudioRate)
+        modulationBuffer.setSize(1, bufferSize);
+}
+
+void Module::ModifiedParameter::fillModulationBuffer(int startSample, int numSamples)
+{
+    jassert(isAudioRate && numSamples <= modulationBuffer.getNumSamples());
+    
+    if (numSamples <= 0)
+        return;
+    
+    auto* dest = modulationBuffer.getWritePointer(0);
+    float offset = 0.f;
+    
+    FloatVectorOperations::clear(dest, numSamples);
+    
+    for (auto& mapping : mappings)
+    {
+        if (mapping.sourceModule == nullptr)
+            continue;
+        
+        //reversing and centring are folded into one scale and offset per mapping
+        float scale  = mapping.reversed ? -1.f : 1.f;
+        float origin = mapping.reversed ? 1.f : 0.f;
+        
+        if (mapping.centred)
+        {
+            scale *= 2.f;
+            origin = origin * 2.f - 1.f;
+        }
+        
+        FloatVectorOperations::addWithMultiply(dest, mapping.sourceModule->getModulationOutput() + startSample,
+                                               scale * mapping.amount, numSamples);
+        offset += origin * mapping.amount;
+    }
+    
+    const float range = parameter->getRange();
+    
+    FloatVectorOperations::multiply(dest, range, numSamples);
+    FloatVectorOperations::add(dest, parameter->getCurrentValue() + offset * range, numSamples);
+    FloatVectorOperations::clip(dest, dest, parameter->getMinValue(), parameter->getMaxValue(), numSamples);
+    
+    modulatedValue = dest[numSamples - 1];
+    chunkRamp = { modulatedValue, modulatedValue };
+    isModulationBufferFilled = true;
+}
+
+const float* Module::ModifiedParameter::getModulationBuffer()
+{
+    if (!isModulationBufferFilled || numMappings == 0)
+        return nullptr;
+    
+    return modulationBuffer.getReadPointer(0);
+}
+
+float Module::ModifiedParameter::calculateModulatedValue(int sampleIndex)
 {
     float normModVal = 0.f;
     
-    for (auto& mapping : currMappings)
+    for (auto& mapping : mappings)
     {
-        float modVal = mapping.sourceModule->internalBuffer.getLastSample();
+        if (mapping.sourceModule == nullptr)
+            continue;
+        
+        const bool readAudioRate = sampleIndex >= 0 && mapping.sourceModule->isAudioRateSource();
+        
+        float modVal = readAudioRate ? mapping.sourceModule->getModulationOutput()[sampleIndex]
+                                     : mapping.sourceModule->internalBuffer.getLastSample();
         
         if (mapping.reversed)
             modVal = 1.f - modVal;
@@ -322,20 +575,28 @@ void Module::ModifiedParameter::calculateAndSendModulation()
         normModVal += modVal * mapping.amount;
     }
     
-    float modifiedValue = float(parameter->getValue());
+    float modifiedValue = parameter->getCurrentValue();
     
     modifiedValue = modifiedValue + normModVal * parameter->getRange();
     modifiedValue = std::clamp(modifiedValue,
                                float(parameter->getMinValue()),
                                float(parameter->getMaxValue()));
     
-    modulatedValue = modifiedValue;
-    parameter->paramChangedCallback(modifiedValue);
+    return modifiedValue;
 }
 
 int Module::ModifiedParameter::getNumMappings()
 {
-    return currMappings.size();
+    return numMappings;
+}
+
+bool Module::ModifiedParameter::isMappedTo(const Module* source) const
+{
+    for (auto& mapping : mappings)
+        if (mapping.sourceModule == source)
+            return true;
+    
+    return false;
 }
 
 float Module::ModifiedParameter::getModulatedValue()
@@ -345,7 +606,9 @@ float Module::ModifiedParameter::getModulatedValue()
 
 void Module::ModifiedParameter::reset()
 {
-    modulatedValue = float(parameter->getValue());
+    isModulationBufferFilled = false;
+    rampStart = rampEnd = modulatedValue = parameter->getCurrentValue();
+    chunkRamp = { modulatedValue, modulatedValue };
 }
 
 inline Identifier Module::ModifiedParameter::getParamName()
@@ -363,6 +626,8 @@ Module::Module()
     //the subclass is fully initiated
     moduleState = getDefaultState("");
     moduleState.addListener(this);
+    
+    enableFade.setCurrentAndTarget(1.f);
 }
 
 Module::~Module() {}
@@ -383,9 +648,65 @@ void Module::reset()
 
 void Module::applyMidi(const MidiMessage& message) {}
 
+void Module::processBlock(float* buffer, int startSample, int numSamples)
+{
+    for (int i = startSample; i < startSample + numSamples; i++)
+        processSample(buffer + i);
+}
+
+void Module::processControl(int numSamples)
+{
+    //sources only ever pass on their latest value, so the output is thrown away
+    float block[maxControlBlockSize];
+    
+    while (numSamples > 0)
+    {
+        const int blockSize = jmin(numSamples, maxControlBlockSize);
+        FloatVectorOperations::fill(block, 1.f, blockSize);
+        processBlock(block, 0, blockSize);
+        numSamples -= blockSize;
+    }
+}
+
 bool Module::isModuleEnabled()
 {
-    return moduleState[ParamIdents::ENABLED];
+    return moduleEnabled;
+}
+
+void Module::applyEnabled(bool shouldBeEnabled)
+{
+    moduleEnabled = shouldBeEnabled;
+    enableFade.setTarget(shouldBeEnabled ? 1.f : 0.f);
+}
+
+void Module::processWithEnableFade(AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = jmin(buffer.getNumChannels(), enableFadeBuffer.getNumChannels());
+    
+    if (!isEnableFading() || numSamples > enableFadeBuffer.getNumSamples())
+    {
+        process(buffer);
+        return;
+    }
+    
+    for (int ch = 0; ch < numChannels; ch++)
+        enableFadeBuffer.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+    
+    process(buffer);
+    
+    //dry + (wet - dry) * fade
+    const auto ramp = getNextEnableRamp(numSamples);
+    
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        auto* wet = buffer.getWritePointer(ch);
+        const auto* dry = enableFadeBuffer.getReadPointer(ch);
+        
+        FloatVectorOperations::subtract(wet, dry, numSamples);
+        ramp.multiply(wet, numSamples);
+        FloatVectorOperations::add(wet, dry, numSamples);
+    }
 }
 
 void Module::setIsDefaultEnabled(bool defaultEnabled)
@@ -419,6 +740,40 @@ std::shared_ptr<Module::ModifiedParameter> Module::getModifiedParam(Identifier p
     return nullptr;
 }
 
+std::shared_ptr<Module::ModifiedParameter> Module::getModifiedParam(int index)
+{
+    return modifiedParameters[index];
+}
+
+BlockRamp Module::getParameterRamp(int index) const
+{
+    auto& param = *modifiedParameters.getUnchecked(index);
+    
+    if (param.getNumMappings() > 0 && !param.isAudioRateModulated())
+        return param.getModulationRamp();
+    
+    const float value = getParameterValue(index);
+    return { value, value };
+}
+
+juce::StringArray Module::getModifiedParamNames()
+{
+    juce::StringArray names;
+    
+    for (auto& param : modifiedParameters)
+        names.add(param->getParamName().toString());
+    
+    return names;
+}
+
+int Module::getModulatedValues(float* dest)
+{
+    for (int i = 0; i < modifiedParameters.size(); i++)
+        dest[i] = modifiedParameters.getUnchecked(i)->getModulatedValue();
+    
+    return modifiedParameters.size();
+}
+
 juce::String Module::getNameInternal()
 {
     return getName() + (instanceId > -1 ? juce::String("_") + juce::String(instanceId+1) : juce::String());
@@ -443,6 +798,13 @@ int Module::getInstanceId()
     return instanceId;
 }
 
+void Module::valueTreePropertyChanged(ValueTree &treeWhosePropertyHasChanged, const Identifier &property)
+{
+    //parameter values arrive here too, they are handled by the parameters
+    if (treeWhosePropertyHasChanged == moduleState && property == ParamIdents::ENABLED)
+        enabledSlot.post(bool(moduleState[ParamIdents::ENABLED]) ? 1.f : 0.f);
+}
+
 void Module::valueTreeChildAdded(ValueTree &parentTree, ValueTree &childWhichHasBeenAdded)
 {
     if (childWhichHasBeenAdded.getType() != ParamIdents::MODULATION)
@@ -534,6 +896,125 @@ void Module::runModulations()
     }
 }
 
+void Module::updateModulationTargets(bool jumpToTarget, int sampleIndex)
+{
+    for (auto& param : modifiedParameters)
+        if (param->getNumMappings() > 0 && !param->isAudioRateModulated())
+            param->setTargetFromSources(jumpToTarget, sampleIndex);
+}
+
+void Module::sendModulations(float startOfChunk, float endOfChunk, int startSample, int numSamples)
+{
+    for (auto& param : modifiedParameters)
+    {
+        if (param->getNumMappings() == 0)
+            continue;
+        
+        if (param->isAudioRateModulated())
+            param->fillModulationBuffer(startSample, numSamples);
+        else
+            param->sendInterpolatedModulation(startOfChunk, endOfChunk);
+    }
+}
+
+void Module::setAudioRateModulation(const Identifier& paramName)
+{
+    auto param = getModifiedParam(paramName);
+    
+    //the parameter must be set up first, see setModuleParameters
+    jassert(param != nullptr);
+    
+    if (param != nullptr)
+        param->setAudioRate(true);
+}
+
+bool Module::hasAudioRateMappingFrom(const Module* source)
+{
+    for (auto& param : modifiedParameters)
+        if (param->isAudioRateModulated() && param->isMappedTo(source))
+            return true;
+    
+    return false;
+}
+
+void Module::prepareModulation(int bufferSize, bool isModulationSource)
+{
+    for (auto& param : modifiedParameters)
+        param->prepareModulationBuffer(bufferSize);
+    
+    if (isModulationSource)
+        modulationOutput.setSize(1, bufferSize);
+}
+
+void Module::prepareEnableFade(float samplerate, int bufferSize, int numChannels)
+{
+    enableFade.prepare(samplerate, enableFadeSeconds);
+    
+    if (numChannels > 0)
+        enableFadeBuffer.setSize(numChannels, bufferSize);
+}
+
+void Module::prepareSleep(float samplerate)
+{
+    sleepSamplerate = samplerate;
+    numSilentSamples = 0;
+    isOutputSilent = true;
+    asleep = false;
+}
+
+bool Module::canSleep(const AudioBuffer<float>& input)
+{
+    const int numSamples = input.getNumSamples();
+    
+    if (input.getMagnitude(0, numSamples) > silenceThreshold || isEnableFading())
+    {
+        numSilentSamples = 0;
+        asleep = false;
+        return false;
+    }
+    
+    numSilentSamples += numSamples;
+    
+    if (!asleep && isOutputSilent)
+    {
+        //the latency holds the tail back too, an infinite tail never sleeps
+        const double tailSamples = getTailLengthSeconds() * sleepSamplerate + getLatencyInSamples();
+        asleep = double(numSilentSamples) >= tailSamples;
+    }
+    
+    return asleep;
+}
+
+void Module::trackOutputLevel(const AudioBuffer<float>& output)
+{
+    isOutputSilent = output.getMagnitude(0, output.getNumSamples()) <= silenceThreshold;
+}
+
+void Module::processModulationOutput(int startSample, int numSamples)
+{
+    jassert(startSample + numSamples <= modulationOutput.getNumSamples());
+    
+    auto* output = modulationOutput.getWritePointer(0);
+    FloatVectorOperations::fill(output + startSample, 1.f, numSamples);
+    processBlock(output, startSample, numSamples);
+}
+
+const float* Module::getModulationOutput()
+{
+    return modulationOutput.getReadPointer(0);
+}
+
+void Module::setParameterQueue(ParameterQueue* queue)
+{
+    enabledSlot.setQueue(queue);
+    
+    for (auto& parameter : moduleParameters)
+        parameter->setParameterQueue(queue);
+    
+    for (auto& parameter : modifiedParameters)
+        parameter->setParameterQueue(queue);
+}
+
 void Module::setModulationSources(Array<Module*> modSources)
 {
     modulationSources = modSources;
@@ -551,6 +1032,7 @@ void Module::setModuleState(ValueTree newModuleState)
     
     moduleState = newModuleState;
     moduleState.addListener(this);
+    valueTreePropertyChanged(moduleState, ParamIdents::ENABLED);
     
     if (moduleState.hasProperty(ParamIdents::INSTANCE_ID))
         setInstanceId(moduleState[ParamIdents::INSTANCE_ID]);
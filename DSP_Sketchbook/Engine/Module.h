@@ -10,6 +10,10 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "ParameterQueue.h"
+#include "ParameterSchema.h"
+#include "Smoothing.h"
+#include "ModuleProfiler.h"
 namespace sketchbook
 {
 
@@ -65,6 +69,26 @@ class Module : public juce::ValueTree::Listener
         juce::var min;
         juce::var max;
         
+        //audio thread copies, so the audio thread never reads a var
+        float currentValue = 0.f;
+        float minValue = 0.f;
+        float maxValue = 0.f;
+        
+        juce::StringArray options;
+        std::function<void(float)> valueCallback;
+        
+        //message thread only, see toNumber
+        float lastChoiceIndex = 0.f;
+        
+        //schema parameters write here rather than calling back
+        std::atomic<float>* storage = nullptr;
+        ParameterQueue::Slot valueSlot { [this] (float value) { applyValue(value); } };
+        
+        //choices are passed around as the index of the option
+        float toNumber(const juce::var& value);
+        
+        void applyValue(float value);
+        
         public:
         
         //Float paramter
@@ -78,6 +102,9 @@ class Module : public juce::ValueTree::Listener
         
         //choice parameter
         ParameterInternal(juce::String name, std::function<void(juce::String)> callback, juce::StringArray options, juce::String initialValue);
+        
+        //schema parameter, the value is kept in storage
+        ParameterInternal(const ParameterSpec& spec, std::atomic<float>& storage);
         /*
          //file Parameter
          Parameter(String name, std::function<void(juce::File)> callback, File fileBrowserFolderToOpenTo);
@@ -94,6 +121,15 @@ class Module : public juce::ValueTree::Listener
         
         std::function<void(juce::var)> paramChangedCallback;
         
+        /** sends a value straight to the module, without going through a var */
+        void sendValue(float value);
+        
+        /** the value last applied on the audio thread, choices are given as an index */
+        float getCurrentValue();
+        
+        /** changes from the value tree are queued to the audio thread, rather than applied as they arrive */
+        void setParameterQueue(ParameterQueue* queue);
+        
         juce::ValueTree getValueTree();
         
         void setValueTree(juce::ValueTree newData);
@@ -141,7 +177,39 @@ class Module : public juce::ValueTree::Listener
     class ModifiedParameter
     {
         
+        public:
+        
+        /** the most sources one parameter can be mapped to at once */
+        static constexpr int maxMappings = 8;
+        
         private:
+        
+        /** a mapping as the audio thread sees it, unused while it has no source */
+        struct MappingState
+        {
+            Module* sourceModule = nullptr;
+            float amount = 1.f;
+            bool centred = false;
+            bool reversed = false;
+        };
+        
+        /**
+         The way into one entry of the mapping array. The message thread writes
+         the pending values and posts the slot, and the audio thread copies them
+         into the entry when the queue is applied
+         */
+        struct PendingMapping
+        {
+            explicit PendingMapping(std::function<void(float)> apply) : slot(std::move(apply)) {}
+            
+            std::atomic<Module*> sourceModule { nullptr };
+            std::atomic<float> amount { 1.f };
+            std::atomic<bool> centred { false };
+            std::atomic<bool> reversed { false };
+            ParameterQueue::Slot slot;
+        };
+        
+        /** the message thread's side of a mapping, which follows its ValueTree */
         class Mapping : juce::ValueTree::Listener
         {
             
@@ -149,40 +217,121 @@ class Module : public juce::ValueTree::Listener
             
             juce::ValueTree data;
             Module* sourceModule;
-            float amount = 1.0;
+            PendingMapping& pending;
             
-            bool centred = false;
-            bool reversed = false;
+            Mapping(juce::ValueTree _data, Module* _sourceModule, PendingMapping& _pending);
+            ~Mapping() override;
+            
+            /** hands the mapping's current values to the audio thread */
+            void post();
             
-            Mapping(juce::ValueTree _data, Module* _sourceModule);
-            Mapping(const Mapping& other);
-            ~Mapping();
             void valueTreePropertyChanged(juce::ValueTree &treeWhosePropertyHasChanged,
                                           const juce::Identifier &property) override;
         };
         
-        juce::Array<Mapping> currMappings;
+        //message thread only
+        juce::OwnedArray<Mapping> currMappings;
+        juce::OwnedArray<PendingMapping> pendingMappings;
+        
+        //audio thread only, written through pendingMappings
+        std::array<MappingState, (size_t) maxMappings> mappings;
+        int numMappings = 0;
+        
+        void applyMapping(int index);
+        
         std::shared_ptr<ParameterInternal> parameter;
         float modulatedValue;
         juce::Identifier parameterName;
         
+        //the values at the last two control ticks, see sendInterpolatedModulation
+        float rampStart = 0.f;
+        float rampEnd = 0.f;
+        
+        //where the parameter goes over the chunk being rendered, see getModulationRamp
+        BlockRamp chunkRamp;
+        
+        //per sample values, for modules that read them directly
+        bool isAudioRate = false;
+        bool isModulationBufferFilled = false;
+        juce::AudioBuffer<float> modulationBuffer;
+        
+        //reads the sources' latest values, or for sources running at audio rate their output at sampleIndex
+        float calculateModulatedValue(int sampleIndex = -1);
+        
         public:
+        
+        /** called on the audio thread when the first mapping is added or the last is removed */
         std::function<void(bool)> onModulationBeginOrEnd;
         
         ModifiedParameter(std::shared_ptr<ParameterInternal> _parameter);
         
+        /**
+         Called from the message thread, the change reaches the audio thread
+         through the parameter queue, see setParameterQueue
+         */
         void addMapping(juce::ValueTree data, Module* source);
         
         void removeMapping(juce::ValueTree data);
         
+        void setParameterQueue(ParameterQueue* queue);
+        
         void calculateAndSendModulation();
         
+        /**
+         Reads the modulation sources and sets the value the parameter will reach
+         at the next control tick. Unless jumpToTarget is set it ramps there
+         from the previous target. Sources running at audio rate are read at
+         sampleIndex, the sample the tick lands on
+         */
+        void setTargetFromSources(bool jumpToTarget, int sampleIndex = -1);
+        
+        /**
+         Sets the ramp for the next chunk from the ramp between the last two
+         control ticks, 0 being the previous target and 1 the new one. The
+         parameter is sent the value at the middle of the chunk, modules that
+         follow it per sample read getModulationRamp instead
+         */
+        void sendInterpolatedModulation(float startOfChunk, float endOfChunk);
+        
+        /**
+         Marks the parameter as one the module reads per sample, through
+         getModulationBuffer, rather than through its callback
+         */
+        void setAudioRate(bool shouldBeAudioRate);
+        
+        bool isAudioRateModulated();
+        
+        void prepareModulationBuffer(int bufferSize);
+        
+        /**
+         Works out the modulated value for every sample in the range from the
+         sources' audio rate output, see Module::getModulationOutput
+         */
+        void fillModulationBuffer(int startSample, int numSamples);
+        
+        /**
+         The per sample values for the stretch being rendered, indexed from its
+         first sample, or nullptr if the parameter is not modulated at audio rate
+         right now and the module should use the value from its callback
+         */
+        const float* getModulationBuffer();
+        
+        /**
+         The parameter's linear ramp across the chunk being rendered. Constant
+         unless it is modulated at control rate, audio rate parameters should
+         be read from getModulationBuffer
+         */
+        BlockRamp getModulationRamp() const;
+        
         float getModulatedValue();
         
         void reset();
         
+        /** the number of mappings the audio thread has, call from the audio thread */
         int getNumMappings();
         
+        bool isMappedTo(const Module* source) const;
+        
         inline juce::Identifier getParamName();
         
         static juce::ValueTree defaultMappingTo(juce::String sourceModName)
@@ -212,14 +361,72 @@ class Module : public juce::ValueTree::Listener
     
     virtual void processSample(float* sample) {};
     
+    /**
+     Processes numSamples of buffer starting at startSample. By default this
+     falls back to calling processSample once per sample - modules should
+     override it so that their inner loop is free of virtual calls
+     */
+    virtual void processBlock(float* buffer, int startSample, int numSamples);
+    
+    /**
+     Used when the module is a modulation source. Advances the source by
+     numSamples and appends its newest value to internalBuffer, the audio itself
+     is not needed. By default this runs processBlock over a small block on the
+     stack, sources that can skip ahead more cheaply should override it
+     */
+    virtual void processControl(int numSamples);
+    
     virtual void process(juce::AudioBuffer<float>& buffer) {}
     
+    /** the delay the module adds to its output, in samples, reported to the host by the engine */
+    virtual float getLatencyInSamples() { return 0.f; }
+    
+    /**
+     How long an effect keeps sounding once its input stops, in seconds, or
+     infinity if it may never stop. Once the input has been silent for this
+     long the engine lets the effect sleep. Called once a block by the engine
+     */
+    virtual double getTailLengthSeconds() { return 0.0; }
+    
     virtual void pitchUpdated(float newPitch) {}
     
     virtual juce::String getName() = 0;
     
     bool isModuleEnabled();
     
+    /**
+     True while the module is enabled or still fading out after being switched
+     off. Modules that are not active are skipped entirely
+     */
+    bool isModuleActive() const
+    {
+        return moduleEnabled.load(std::memory_order_relaxed) || enableFade.getCurrentValue() > 0.f;
+    }
+    
+    /** true while the module is crossfading after being switched on or off */
+    bool isEnableFading() const
+    {
+        return enableFade.isSmoothing();
+    }
+    
+    /** the gain of the module's output over the next numSamples while it is fading, see isEnableFading */
+    BlockRamp getNextEnableRamp(int numSamples)
+    {
+        return enableFade.getNextRamp(numSamples);
+    }
+    
+    /** finishes any enable fade at once, for a voice that was switched on or off while it was silent */
+    void skipEnableFade()
+    {
+        enableFade.setCurrentAndTarget(enableFade.getTarget());
+    }
+    
+    /**
+     Calls process, crossfading between the processed and unprocessed signal
+     while the module is switched on or off
+     */
+    void processWithEnableFade(juce::AudioBuffer<float>& buffer);
+    
     /**
      By default this will be true
      */
@@ -233,6 +440,26 @@ class Module : public juce::ValueTree::Listener
     
     std::shared_ptr<ModifiedParameter> getModifiedParam(juce::Identifier paramName);
     
+    /** looks a parameter up by its index, as declared in the schema or passed to setModuleParameters */
+    std::shared_ptr<ModifiedParameter> getModifiedParam(int index);
+    
+    /** the names of the module's parameters, in the order getModulatedValues writes them */
+    juce::StringArray getModifiedParamNames();
+    
+    /** writes the current modulated value of every parameter to dest and returns how many were written */
+    int getModulatedValues(float* dest);
+    
+    /** where the time spent processing the module is counted, see ModuleProfiler */
+    void setProfilerCounter(ModuleProfiler::Counter* counter)
+    {
+        profilerCounter = counter;
+    }
+    
+    ModuleProfiler::Counter* getProfilerCounter() const
+    {
+        return profilerCounter;
+    }
+    
     juce::String getNameInternal();
     
     void setInstanceId(int _id);
@@ -243,6 +470,91 @@ class Module : public juce::ValueTree::Listener
     //parameters and calculate their next values
     void runModulations();
     
+    /**
+     The control rate version of runModulations, called once per control tick.
+     Works out where each modulated parameter is heading, see
+     ModifiedParameter::setTargetFromSources
+     */
+    void updateModulationTargets(bool jumpToTarget, int sampleIndex = -1);
+    
+    /**
+     Sends every modulated parameter its interpolated value, called between
+     control ticks with where the stretch starts and ends as proportions of the
+     tick. Audio rate parameters have their buffers filled for the stretch
+     instead
+     */
+    void sendModulations(float startOfChunk, float endOfChunk, int startSample, int numSamples);
+    
+    /** the longest stretch processControl's default works on at once */
+    static constexpr int maxControlBlockSize = 64;
+    
+    /**
+     Opts a parameter in to audio rate modulation. Call from the constructor of
+     a module whose processBlock reads ModifiedParameter::getModulationBuffer
+     */
+    void setAudioRateModulation(const juce::Identifier& paramName);
+    
+    /** true if an audio rate parameter of this module is mapped to the source, so that source must run per sample */
+    bool hasAudioRateMappingFrom(const Module* source);
+    
+    /** set on a modulation source by its voice while it is run per sample, see processModulationOutput */
+    void setAudioRateSource(bool shouldRunAtAudioRate)
+    {
+        audioRateSource = shouldRunAtAudioRate;
+    }
+    
+    bool isAudioRateSource() const
+    {
+        return audioRateSource;
+    }
+    
+    /**
+     Allocates the per sample buffers, called alongside prepareToPlay. Modulation
+     sources also get a buffer for their audio rate output
+     */
+    void prepareModulation(int bufferSize, bool isModulationSource);
+    
+    /**
+     Sets the length of the crossfade used when the module is switched on or
+     off, called alongside prepareToPlay. Effects pass the number of channels
+     they process, so that the unprocessed signal can be kept for the fade
+     */
+    void prepareEnableFade(float samplerate, int bufferSize, int numChannels = 0);
+    
+    /** resets the silence tracking used to put an effect to sleep, called alongside prepareToPlay */
+    void prepareSleep(float samplerate);
+    
+    /**
+     Called by the engine with an effect's input before processing it. Returns
+     true if the block can be skipped, because the input has been silent for
+     longer than the tail and the last output had decayed. Any input that is
+     not silent wakes the effect straight away
+     */
+    bool canSleep(const juce::AudioBuffer<float>& input);
+    
+    /** called by the engine with an effect's output, so that it only sleeps once the output has decayed */
+    void trackOutputLevel(const juce::AudioBuffer<float>& output);
+    
+    bool isAsleep() const
+    {
+        return asleep;
+    }
+    
+    /**
+     Renders a modulation source per sample into its modulation output, rather
+     than just keeping its latest value up to date as processControl does
+     */
+    void processModulationOutput(int startSample, int numSamples);
+    
+    /** the output of the last call to processModulationOutput, indexed by sample */
+    const float* getModulationOutput();
+    
+    /**
+     Routes changes to the module's parameters and enabled state through the
+     queue, so that they are applied at the start of the next block
+     */
+    void setParameterQueue(ParameterQueue* queue);
+    
     static juce::ValueTree getDefaultState(juce::String name)
     {
         juce::ValueTree output(ParamIdents::MODULE);
@@ -298,6 +610,9 @@ class Module : public juce::ValueTree::Listener
         static const juce::Identifier EFFECT_FILTERS;
     };
     
+    void valueTreePropertyChanged(juce::ValueTree &treeWhosePropertyHasChanged,
+                                  const juce::Identifier &property) override;
+    
     void valueTreeChildAdded(juce::ValueTree &parentTree,
                              juce::ValueTree &childWhichHasBeenAdded) override;
     
@@ -307,6 +622,42 @@ class Module : public juce::ValueTree::Listener
     
     void setModuleParameters(juce::Array<std::shared_ptr<Module::ParameterInternal>> parameters);
     
+    /**
+     Sets up the module's parameters from a schema. Instead of calling back,
+     every parameter keeps its value, with any modulation applied, in a slot
+     indexed by its place in the schema, see getParameterValue
+     */
+    template <size_t NumParameters>
+    void setModuleParameters(const ParameterSchema<NumParameters>& schema)
+    {
+        parameterValues.setSize(schema.size());
+        
+        juce::Array<std::shared_ptr<Module::ParameterInternal>> parameters;
+        
+        for (int i = 0; i < schema.size(); i++)
+            parameters.add(std::make_shared<ParameterInternal>(schema[i], parameterValues[i]));
+        
+        setModuleParameters(parameters);
+    }
+    
+    /** the value of a schema parameter, choices are given as the index of the option */
+    float getParameterValue(int index) const
+    {
+        return parameterValues.get(index);
+    }
+    
+    const ParameterValues& getParameterValues() const
+    {
+        return parameterValues;
+    }
+    
+    /**
+     A schema parameter's ramp across the stretch being rendered, which moves
+     while it is modulated at control rate and is otherwise its value. Modules
+     apply it per sample so that modulation does not step at each chunk
+     */
+    BlockRamp getParameterRamp(int index) const;
+    
     void applyAllParameters();
     
     void setModulationSources(juce::Array<Module*> modSources);
@@ -322,11 +673,36 @@ class Module : public juce::ValueTree::Listener
     private:
     juce::Array< std::shared_ptr<Module::ModifiedParameter>> modifiedParameters;
     juce::Array< std::shared_ptr<Module::ParameterInternal>> moduleParameters;
+    ParameterValues parameterValues;
     bool isProcessingBuffer=false;
     juce::Array<Module*> modulationSources;
+    juce::AudioBuffer<float> modulationOutput;
+    bool audioRateSource = false;
     VoiceMonitorType voiceMonitorType = adsr;
     int instanceId = -1; ///If there are more that one instances of a module, this number will be appened to the name - else will be -1
     bool isDefaultEnabled = true;
+    
+    //a copy of the ENABLED property for the audio thread
+    std::atomic<bool> moduleEnabled { true };
+    ParameterQueue::Slot enabledSlot { [this] (float value) { applyEnabled(value > 0.5f); } };
+    
+    void applyEnabled(bool shouldBeEnabled);
+    
+    //runs from 0 (off) to 1 (on) when the module is toggled
+    BlockSmoother enableFade;
+    juce::AudioBuffer<float> enableFadeBuffer;
+    static constexpr double enableFadeSeconds = 0.01;
+    
+    //how long an effect's input has been silent, see canSleep
+    float sleepSamplerate = 44100.f;
+    juce::int64 numSilentSamples = 0;
+    bool isOutputSilent = true;
+    bool asleep = false;
+    
+    //-100dB, anything quieter counts as silence
+    static constexpr float silenceThreshold = 1.0e-5f;
+    
+    ModuleProfiler::Counter* profilerCounter = nullptr;
 };
 
 //==============================================================================
@@ -337,12 +713,20 @@ class ModuleList
     
     public:
     
+    static constexpr size_t size = sizeof...(Modules);
+    
     template <typename Fn>
     constexpr void forEach(Fn&& fn)
     {
         forEachInTuple(fn, modules);
     }
     
+    template <size_t Index>
+    auto& get()
+    {
+        return std::get<Index>(modules);
+    }
+    
     juce::Array<Module*> toArray()
     {
         juce::Array<Module*> result;
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    ModuleProfiler.cpp
+    Created: 16 Oct 2026 11:31:09pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "ModuleProfiler.h"
+
+namespace sketchbook
+{
+
+int ModuleProfiler::addProbe(const juce::String& name)
+{
+    //must be registered before the counters are made
+    jassert(counters == nullptr);
+    
+    names.addIfNotAlreadyThere(name);
+    return names.indexOf(name);
+}
+
+void ModuleProfiler::allocate()
+{
+    counters = std::make_unique<Counter[]>((size_t) names.size());
+    
+    for (int i = 0; i < names.size(); i++)
+        counters[(size_t) i].store(0, std::memory_order_relaxed);
+}
+
+ModuleProfiler::Counter* ModuleProfiler::getCounter(int probeId)
+{
+    if (counters == nullptr || !juce::isPositiveAndBelow(probeId, names.size()))
+        return nullptr;
+    
+    return &counters[(size_t) probeId];
+}
+
+juce::uint64 ModuleProfiler::getCycles(int probeId) const
+{
+    if (counters == nullptr || !juce::isPositiveAndBelow(probeId, names.size()))
+        return 0;
+    
+    return counters[(size_t) probeId].load(std::memory_order_relaxed);
+}
+    
+} //end namespace sketchbook
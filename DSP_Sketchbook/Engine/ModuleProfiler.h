@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    ModuleProfiler.h
+    Created: 16 Oct 2026 11:31:09pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ Counts the cycles spent in each module, in the modulation and in the engine
+ as a whole, so the UI can show where the time goes.
+ 
+ Probes are registered by name while the engine is built and each is given a
+ counter. ScopedProbe adds the cycles spent in its scope to a counter, the
+ counters only ever grow and are read by the UI without locking, which works
+ out shares from how much each has grown between reads. Voices rendering the
+ same module add to the same counter, possibly from different threads.
+ 
+ The probes are only compiled in with SKETCHBOOK_ENABLE_PROFILING, otherwise
+ ScopedProbe does nothing at all.
+ */
+class ModuleProfiler
+{
+    public:
+    
+    using Counter = std::atomic<juce::uint64>;
+    
+    /** the probe around everything the engine does in a block */
+    static constexpr const char* engineProbeName = "Engine";
+    
+    /** the probe around working out and sending the modulated parameter values */
+    static constexpr const char* modulationProbeName = "Modulation";
+    
+    static constexpr bool isEnabled()
+    {
+        return SKETCHBOOK_ENABLE_PROFILING != 0;
+    }
+    
+    /** registers a probe and returns its id, a name that is already registered returns the same id */
+    int addProbe(const juce::String& name);
+    
+    /** the id of a registered probe, or -1 */
+    int getProbeId(const juce::String& name) const
+    {
+        return names.indexOf(name);
+    }
+    
+    int getNumProbes() const
+    {
+        return names.size();
+    }
+    
+    juce::String getProbeName(int probeId) const
+    {
+        return names[probeId];
+    }
+    
+    /** makes the counters once every probe is registered, allocates */
+    void allocate();
+    
+    /** the counter a probe adds to, or nullptr for an id that is not registered */
+    Counter* getCounter(int probeId);
+    
+    /** the cycles counted by a probe so far */
+    juce::uint64 getCycles(int probeId) const;
+    
+    /** a cycle counter, or the high resolution ticks where there is none */
+    static juce::uint64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+        return __builtin_ia32_rdtsc();
+       #elif JUCE_INTEL && JUCE_MSVC
+        return __rdtsc();
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    //==============================================================================
+    /** adds the cycles spent in its scope to a counter, which may be null */
+    class ScopedProbe
+    {
+        public:
+        
+        explicit ScopedProbe(Counter* counterToAddTo) noexcept
+        {
+           #if SKETCHBOOK_ENABLE_PROFILING
+            counter = counterToAddTo;
+            start = counter != nullptr ? readCycleCounter() : 0;
+           #else
+            juce::ignoreUnused(counterToAddTo);
+           #endif
+        }
+        
+        ~ScopedProbe() noexcept
+        {
+           #if SKETCHBOOK_ENABLE_PROFILING
+            if (counter != nullptr)
+                counter->fetch_add(readCycleCounter() - start, std::memory_order_relaxed);
+           #endif
+        }
+        
+        private:
+       
+       #if SKETCHBOOK_ENABLE_PROFILING
+        Counter* counter = nullptr;
+        juce::uint64 start = 0;
+       #endif
+        
+        JUCE_DECLARE_NON_COPYABLE(ScopedProbe)
+    };
+    
+    private:
+    
+    juce::StringArray names;
+    std::unique_ptr<Counter[]> counters;
+};
+    
+} //end namespace sketchbook
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: 16 Oct 2026 10:52:18pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+namespace sketchbook
+{
+
+juce::Result OfflineRender::readMidiFile(const juce::File& file, double sampleRate, juce::MidiBuffer& dest, int& lastEventSample)
+{
+    juce::FileInputStream stream(file);
+    
+    if (stream.failedToOpen())
+        return juce::Result::fail("could not open " + file.getFullPathName());
+    
+    juce::MidiFile midiFile;
+    
+    if (!midiFile.readFrom(stream))
+        return juce::Result::fail("could not read midi from " + file.getFullPathName());
+    
+    //tempo changes are applied as the times are converted to seconds
+    midiFile.convertTimestampTicksToSeconds();
+    
+    dest.clear();
+    lastEventSample = 0;
+    
+    for (int track = 0; track < midiFile.getNumTracks(); track++)
+    {
+        for (auto* event : *midiFile.getTrack(track))
+        {
+            const auto& message = event->message;
+            
+            if (message.isMetaEvent() || message.isSysEx())
+                continue;
+            
+            const int samplePosition = juce::roundToInt(message.getTimeStamp() * sampleRate);
+            dest.addEvent(message, samplePosition);
+            lastEventSample = juce::jmax(lastEventSample, samplePosition);
+        }
+    }
+    
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRender::readStateFile(const juce::File& file, juce::ValueTree& dest)
+{
+    auto xml = juce::XmlDocument::parse(file);
+    
+    if (xml == nullptr)
+        return juce::Result::fail("could not read a state from " + file.getFullPathName());
+    
+    dest = juce::ValueTree::fromXml(*xml);
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRender::writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate, int bitDepth)
+{
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    
+    if (stream->failedToOpen())
+        return juce::Result::fail("could not open " + file.getFullPathName() + " for writing");
+    
+    juce::WavAudioFormat format;
+    std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate, (unsigned int) audio.getNumChannels(),
+                                                                           bitDepth, {}, 0));
+    
+    if (writer == nullptr)
+        return juce::Result::fail("could not write a " + juce::String(bitDepth) + " bit wav file");
+    
+    //the writer owns the stream from here
+    stream.release();
+    
+    if (!writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples()))
+        return juce::Result::fail("could not write to " + file.getFullPathName());
+    
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRender::readWavFile(const juce::File& file, juce::AudioBuffer<float>& dest, double& sampleRate)
+{
+    auto stream = file.createInputStream();
+    
+    if (stream == nullptr)
+        return juce::Result::fail("could not open " + file.getFullPathName());
+    
+    juce::WavAudioFormat format;
+    std::unique_ptr<juce::AudioFormatReader> reader(format.createReaderFor(stream.release(), true));
+    
+    if (reader == nullptr)
+        return juce::Result::fail("could not read a wav file from " + file.getFullPathName());
+    
+    dest.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+    sampleRate = reader->sampleRate;
+    
+    if (!reader->read(&dest, 0, dest.getNumSamples(), 0, true, true))
+        return juce::Result::fail("could not read " + file.getFullPathName());
+    
+    return juce::Result::ok();
+}
+
+juce::String OfflineRender::getStatistics(const juce::Array<RenderResult>& results, double wallClockSeconds)
+{
+    juce::String text;
+    double totalAudioSeconds = 0.0;
+    double minFactor = std::numeric_limits<double>::max();
+    double maxFactor = 0.0;
+    int numFailed = 0;
+    
+    for (auto& render : results)
+    {
+        if (render.result.failed())
+        {
+            numFailed++;
+            text << render.job.outputFile.getFileName() << ": " << render.result.getErrorMessage() << juce::newLine;
+            continue;
+        }
+        
+        text << render.job.outputFile.getFileName() << ": "
+             << juce::String(render.audioSeconds, 2) << "s of audio in "
+             << juce::String(render.renderSeconds, 3) << "s, "
+             << juce::String(render.getRealtimeFactor(), 1) << "x realtime" << juce::newLine;
+        
+        totalAudioSeconds += render.audioSeconds;
+        minFactor = juce::jmin(minFactor, render.getRealtimeFactor());
+        maxFactor = juce::jmax(maxFactor, render.getRealtimeFactor());
+    }
+    
+    const int numRendered = results.size() - numFailed;
+    text << juce::newLine << numRendered << " rendered, " << numFailed << " failed" << juce::newLine;
+    
+    if (numRendered > 0)
+    {
+        text << "realtime factor per render: " << juce::String(minFactor, 1) << "x to " << juce::String(maxFactor, 1) << "x" << juce::newLine;
+        
+        //across every render at once, which is what running them in parallel gains
+        if (wallClockSeconds > 0.0)
+            text << "overall: " << juce::String(totalAudioSeconds, 2) << "s of audio in " << juce::String(wallClockSeconds, 3) << "s, "
+                 << juce::String(totalAudioSeconds / wallClockSeconds, 1) << "x realtime" << juce::newLine;
+    }
+    
+    return text;
+}
+    
+} //end namespace sketchbook
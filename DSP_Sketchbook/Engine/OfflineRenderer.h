@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 16 Oct 2026 10:52:18pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/** a midi file played through a saved state, written to a wav file */
+struct RenderJob
+{
+    juce::File midiFile;
+    
+    /** a state saved from AudioEngine::getState as xml, the default state is used if this is left empty */
+    juce::File stateFile;
+    
+    juce::File outputFile;
+};
+
+struct RenderSettings
+{
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int numChannels = 2;
+    int bitDepth = 24;
+    
+    /** how long rendering carries on after the last midi event, so that releases and tails are kept */
+    double tailSeconds = 2.0;
+    
+    /** the threads each engine renders its voices on, see VoiceController::setNumRenderThreads */
+    int numRenderThreads = 1;
+};
+
+struct RenderResult
+{
+    RenderJob job;
+    juce::Result result = juce::Result::ok();
+    
+    /** the length of the audio that was rendered */
+    double audioSeconds = 0.0;
+    
+    /** the time spent processing, reading and writing files is not counted */
+    double renderSeconds = 0.0;
+    
+    /** how many times faster than real time the render ran */
+    double getRealtimeFactor() const
+    {
+        return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0;
+    }
+};
+
+//==============================================================================
+/** the parts of an offline render that do not depend on the engine */
+namespace OfflineRender
+{
+    /** reads every track of a midi file into one buffer, timed in samples, and returns the time of the last event */
+    juce::Result readMidiFile(const juce::File& file, double sampleRate, juce::MidiBuffer& dest, int& lastEventSample);
+    
+    /** reads a state saved as xml */
+    juce::Result readStateFile(const juce::File& file, juce::ValueTree& dest);
+    
+    juce::Result writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate, int bitDepth);
+    
+    /** reads a whole wav file into dest, which is resized to fit */
+    juce::Result readWavFile(const juce::File& file, juce::AudioBuffer<float>& dest, double& sampleRate);
+    
+    /** a summary of a set of renders: how many failed, and the realtime factor of each and overall */
+    juce::String getStatistics(const juce::Array<RenderResult>& results, double wallClockSeconds);
+}
+
+//==============================================================================
+/**
+ Renders midi files through an AudioEngine faster than real time, with no
+ editor or audio device.
+ 
+ Every render builds its own engine, so renders are independent of each
+ other and renderAll can run as many at once as there are cores. The engine
+ renders its voices on the calling thread unless it is told otherwise, so
+ parallel renders do not compete with the engine's own render threads.
+ */
+template <typename EngineType>
+class OfflineRenderer
+{
+    public:
+    
+    explicit OfflineRenderer(RenderSettings renderSettings = {})
+        : settings(renderSettings)
+    {
+    }
+    
+    const RenderSettings& getSettings() const
+    {
+        return settings;
+    }
+    
+    /** renders one job on the calling thread, allocates */
+    RenderResult render(const RenderJob& job) const
+    {
+        RenderResult output;
+        output.job = job;
+        
+        juce::MidiBuffer midi;
+        int lastEventSample = 0;
+        output.result = OfflineRender::readMidiFile(job.midiFile, settings.sampleRate, midi, lastEventSample);
+        
+        juce::ValueTree state;
+        
+        if (output.result.wasOk() && job.stateFile != juce::File())
+            output.result = OfflineRender::readStateFile(job.stateFile, state);
+        
+        if (output.result.failed())
+            return output;
+        
+        const int numSamples = lastEventSample + juce::roundToInt(settings.tailSeconds * settings.sampleRate);
+        juce::AudioBuffer<float> audio;
+        
+        output.renderSeconds = renderToBuffer(midi, numSamples, state, audio);
+        output.audioSeconds = numSamples / settings.sampleRate;
+        
+        output.result = OfflineRender::writeWavFile(job.outputFile, audio, settings.sampleRate, settings.bitDepth);
+        return output;
+    }
+    
+    /**
+     Renders numSamples of midi, timed in samples, through a new engine into
+     dest, which is resized to fit. The state may be invalid for the default
+     one. Returns the time spent processing in seconds, allocates
+     */
+    double renderToBuffer(const juce::MidiBuffer& midi, int numSamples, const juce::ValueTree& state, juce::AudioBuffer<float>& dest) const
+    {
+        //engines hold all of their voices, too much for the stack
+        auto engine = std::make_unique<EngineType>();
+        
+        if (state.isValid())
+            engine->setState(state);
+        
+        engine->setNumRenderThreads(settings.numRenderThreads);
+        engine->prepare(float(settings.sampleRate), settings.blockSize, settings.numChannels);
+        
+        dest.setSize(settings.numChannels, numSamples);
+        dest.clear();
+        
+        juce::MidiBuffer blockMidi;
+        blockMidi.ensureSize((size_t) midi.data.size());
+        
+        const double startTime = juce::Time::getMillisecondCounterHiRes();
+        
+        for (int start = 0; start < numSamples; start += settings.blockSize)
+        {
+            const int blockLength = juce::jmin(settings.blockSize, numSamples - start);
+            
+            //the block refers to the output, so the engine renders straight into it
+            juce::AudioBuffer<float> block(dest.getArrayOfWritePointers(), settings.numChannels, start, blockLength);
+            
+            blockMidi.clear();
+            blockMidi.addEvents(midi, start, blockLength, -start);
+            
+            engine->process(block, blockMidi, 0, blockLength);
+        }
+        
+        return (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    }
+    
+    /**
+     Renders every job, up to numThreads at a time, 0 being one per core. The
+     results are in the same order as the jobs
+     */
+    juce::Array<RenderResult> renderAll(const juce::Array<RenderJob>& jobs, int numThreads = 0) const
+    {
+        juce::Array<RenderResult> results;
+        results.resize(jobs.size());
+        
+        if (numThreads <= 0)
+            numThreads = juce::SystemStats::getNumCpus();
+        
+        numThreads = juce::jmin(numThreads, jobs.size());
+        
+        if (numThreads <= 1)
+        {
+            for (int i = 0; i < jobs.size(); i++)
+                results.setUnchecked(i, render(jobs.getReference(i)));
+            
+            return results;
+        }
+        
+        juce::ThreadPool pool(juce::ThreadPoolOptions{}.withNumberOfThreads(numThreads));
+        
+        for (int i = 0; i < jobs.size(); i++)
+        {
+            pool.addJob([this, &jobs, &results, i]
+            {
+                results.setUnchecked(i, render(jobs.getReference(i)));
+            });
+        }
+        
+        //each job writes only its own result
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep(10);
+        
+        return results;
+    }
+    
+    private:
+    
+    RenderSettings settings;
+};
+    
+} //end namespace sketchbook
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    Oversampled.h
+    Created: 16 Oct 2026 10:24:51pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Module.h"
+
+namespace sketchbook
+{
+
+/**
+ Runs a module at Factor times the host rate, for modules that alias, such as
+ waveshapers. The signal is taken up through polyphase half-band filters
+ before the module and back down after it, so only the modules that are
+ wrapped pay for oversampling, each at its own factor.
+ 
+ It takes the place of the module in a ModuleList, with the same name and
+ parameters, e.g.
+     
+     AudioEngine<ModuleList<SimpleOsc>, ModuleList<Oversampled<Distortion, 4>, Convolution>>
+ 
+ The wrapped module is prepared at the raised sample rate and block size.
+ Audio rate modulation is laid out at the host rate, so the module's
+ parameters are modulated at control rate instead.
+ 
+ The filters add latency, see getLatencyInSamples. Effects take up to
+ maxNumChannels channels, any more are passed through.
+ */
+template <typename ModuleType, int Factor>
+class Oversampled : public ModuleType
+{
+    static_assert(std::is_base_of<Module, ModuleType>::value, "Oversampled can only wrap a Module");
+    static_assert(Factor == 2 || Factor == 4 || Factor == 8 || Factor == 16, "Factor must be 2, 4, 8 or 16");
+    
+    public:
+    
+    static constexpr int maxNumChannels = 2;
+    
+    Oversampled()
+    {
+        for (int i = 0; i < Module::getModifiedParamNames().size(); i++)
+            if (auto param = Module::getModifiedParam(i))
+                param->setAudioRate(false);
+    }
+    
+    void prepareToPlay(float samplerate, int buffersize) override
+    {
+        oversampling = std::make_unique<juce::dsp::Oversampling<float>>((size_t) maxNumChannels, (size_t) factorLog2,
+                                                                        juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true);
+        oversampling->initProcessing((size_t) buffersize);
+        
+        ModuleType::prepareToPlay(samplerate * float(Factor), buffersize * Factor);
+    }
+    
+    void reset() override
+    {
+        ModuleType::reset();
+        
+        if (oversampling != nullptr)
+            oversampling->reset();
+    }
+    
+    void processBlock(float* buffer, int startSample, int numSamples) override
+    {
+        if (numSamples <= 0)
+            return;
+        
+        float* channels[] = { buffer + startSample };
+        juce::dsp::AudioBlock<float> block(channels, 1, (size_t) numSamples);
+        
+        auto upsampled = oversampling->processSamplesUp(block);
+        ModuleType::processBlock(upsampled.getChannelPointer(0), 0, (int) upsampled.getNumSamples());
+        oversampling->processSamplesDown(block);
+    }
+    
+    void process(juce::AudioBuffer<float>& buffer) override
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), maxNumChannels);
+        
+        if (numChannels == 0 || buffer.getNumSamples() == 0)
+            return;
+        
+        auto block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, (size_t) numChannels);
+        auto upsampled = oversampling->processSamplesUp(block);
+        
+        //refers to the oversampling's own memory, nothing is copied or allocated
+        std::array<float*, (size_t) maxNumChannels> channels {};
+        
+        for (int ch = 0; ch < numChannels; ch++)
+            channels[(size_t) ch] = upsampled.getChannelPointer((size_t) ch);
+        
+        juce::AudioBuffer<float> upsampledBuffer(channels.data(), numChannels, (int) upsampled.getNumSamples());
+        ModuleType::process(upsampledBuffer);
+        
+        oversampling->processSamplesDown(block);
+    }
+    
+    /** the delay of the filters plus the module's own, in samples at the host rate */
+    float getLatencyInSamples() override
+    {
+        const float filterLatency = oversampling != nullptr ? oversampling->getLatencyInSamples() : 0.f;
+        return filterLatency + ModuleType::getLatencyInSamples() / float(Factor);
+    }
+    
+    private:
+    
+    static constexpr int factorLog2 = Factor == 2 ? 1 : Factor == 4 ? 2 : Factor == 8 ? 3 : 4;
+    
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+};
+    
+} //end namespace sketchbook
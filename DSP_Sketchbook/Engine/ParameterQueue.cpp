@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    ParameterQueue.cpp
+    Created: 16 Oct 2026 6:02:31pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "ParameterQueue.h"
+
+namespace sketchbook
+{
+
+ParameterQueue::Slot::Slot(std::function<void(float)> applyValue)
+: apply(std::move(applyValue))
+{
+}
+
+void ParameterQueue::Slot::setQueue(ParameterQueue* newQueue)
+{
+    if (newQueue == queue)
+        return;
+    
+    //each queue counts only the slots attached to it now, see allocate
+    if (queue != nullptr)
+        queue->numSlots--;
+    
+    queue = newQueue;
+    
+    if (queue != nullptr)
+        queue->numSlots++;
+}
+
+void ParameterQueue::Slot::post(float value)
+{
+    if (queue == nullptr)
+    {
+        apply(value);
+        return;
+    }
+    
+    pendingValue.store(value, std::memory_order_release);
+    
+    //already waiting, the audio thread will pick up the new value
+    if (!isQueued.exchange(true, std::memory_order_acq_rel))
+        queue->push(*this);
+}
+
+//==============================================================================
+ParameterQueue::ParameterQueue()
+{
+}
+
+void ParameterQueue::allocate()
+{
+    //a slot is queued at most once, and the fifo keeps one space free
+    fifo.setTotalSize(numSlots + 1);
+    queuedSlots.assign((size_t) numSlots + 1, nullptr);
+    slotsToApply.assign((size_t) numSlots, nullptr);
+}
+
+void ParameterQueue::push(Slot& slot)
+{
+    const auto scope = fifo.write(1);
+    
+    //a slot was attached after allocate was called
+    jassert(scope.blockSize1 + scope.blockSize2 == 1);
+    
+    if (scope.blockSize1 > 0)
+        queuedSlots[(size_t) scope.startIndex1] = &slot;
+    else if (scope.blockSize2 > 0)
+        queuedSlots[(size_t) scope.startIndex2] = &slot;
+}
+
+void ParameterQueue::applyPending()
+{
+    int numToApply = 0;
+    
+    {
+        //the slots are copied out and their space handed back before any is cleared, so that
+        //a slot posted again straight after it is cleared always finds room in the fifo
+        const auto scope = fifo.read(juce::jmin(fifo.getNumReady(), (int) slotsToApply.size()));
+        
+        for (int i = 0; i < scope.blockSize1; i++)
+            slotsToApply[(size_t) numToApply++] = queuedSlots[(size_t) (scope.startIndex1 + i)];
+        
+        for (int i = 0; i < scope.blockSize2; i++)
+            slotsToApply[(size_t) numToApply++] = queuedSlots[(size_t) (scope.startIndex2 + i)];
+    }
+    
+    for (int i = 0; i < numToApply; i++)
+    {
+        auto* slot = slotsToApply[(size_t) i];
+        
+        //cleared first so that a value posted from here on queues the slot again
+        slot->isQueued.exchange(false, std::memory_order_acq_rel);
+        slot->apply(slot->pendingValue.load(std::memory_order_acquire));
+    }
+}
+    
+} //end namespace sketchbook
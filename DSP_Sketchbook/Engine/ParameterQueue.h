@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    ParameterQueue.h
+    Created: 16 Oct 2026 6:02:31pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ Carries parameter changes from the message thread to the audio thread.
+ 
+ Each parameter owns a Slot holding its newest value. Posting to a slot queues
+ it, unless it is already waiting, so a burst of changes to one parameter is
+ applied as a single update and the fifo can never fill up. The fifo is single
+ producer, single consumer - slots are posted to from the message thread and
+ applyPending is called from the audio thread at the start of each block.
+ */
+class ParameterQueue
+{
+    public:
+    
+    class Slot
+    {
+        public:
+        
+        /** applyValue is called on the audio thread, or straight away if the slot has no queue */
+        explicit Slot(std::function<void(float)> applyValue);
+        
+        void setQueue(ParameterQueue* newQueue);
+        
+        /** called from the message thread */
+        void post(float value);
+        
+        private:
+        
+        friend class ParameterQueue;
+        
+        std::function<void(float)> apply;
+        std::atomic<float> pendingValue { 0.f };
+        std::atomic<bool> isQueued { false };
+        ParameterQueue* queue = nullptr;
+        
+        JUCE_DECLARE_NON_COPYABLE (Slot)
+    };
+    
+    ParameterQueue();
+    
+    /**
+     Sizes the fifo so that every slot attached so far can be waiting at once.
+     Call once every slot has been attached and before any are posted to
+     */
+    void allocate();
+    
+    /** applies every change posted since the last call, called from the audio thread */
+    void applyPending();
+    
+    private:
+    
+    void push(Slot& slot);
+    
+    int numSlots = 0;
+    juce::AbstractFifo fifo { 1 };
+    std::vector<Slot*> queuedSlots;
+    
+    //the audio thread's copy of the slots read by applyPending
+    std::vector<Slot*> slotsToApply;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterQueue)
+};
+    
+} //end namespace sketchbook
@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    ParameterSchema.h
+    Created: 16 Oct 2026 7:24:10pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <string_view>
+
+namespace sketchbook
+{
+
+/**
+ A parameter declared at compile time, see ParameterSchema
+ */
+struct ParameterSpec
+{
+    enum class Type
+    {
+        floatParam = 0, intParam, boolParam, choiceParam
+    };
+    
+    std::string_view name;
+    Type type = Type::floatParam;
+    float defaultValue = 0.f;
+    float minValue = 0.f;
+    float maxValue = 1.f;
+    
+    //separated by ';' as they are in the value tree, choices are stored as the index of the option
+    std::string_view options;
+    
+    static constexpr ParameterSpec Float(std::string_view name, float defaultValue, float minValue, float maxValue)
+    {
+        return { name, Type::floatParam, defaultValue, minValue, maxValue, {} };
+    }
+    
+    static constexpr ParameterSpec Integer(std::string_view name, int defaultValue, int minValue, int maxValue)
+    {
+        return { name, Type::intParam, float(defaultValue), float(minValue), float(maxValue), {} };
+    }
+    
+    static constexpr ParameterSpec Boolean(std::string_view name, bool defaultValue = true)
+    {
+        return { name, Type::boolParam, defaultValue ? 1.f : 0.f, 0.f, 1.f, {} };
+    }
+    
+    static constexpr ParameterSpec Choice(std::string_view name, std::string_view options, int defaultIndex)
+    {
+        int numOptions = 1;
+        
+        for (auto c : options)
+            if (c == ';')
+                numOptions++;
+        
+        return { name, Type::choiceParam, float(defaultIndex), 0.f, float(numOptions - 1), options };
+    }
+};
+
+/**
+ The parameters of a module, declared as a constexpr list. Parameters are
+ referred to by their index in the list, which indexOf can resolve at compile
+ time, for example
+ 
+     static constexpr auto parameters = makeParameterSchema(ParameterSpec::Float("Gain", 0.5f, 0.f, 1.f));
+     static constexpr int gainParam = parameters.indexOf("Gain");
+ 
+ see Module::setModuleParameters
+ */
+template <size_t NumParameters>
+struct ParameterSchema
+{
+    std::array<ParameterSpec, NumParameters> parameters;
+    
+    static constexpr int size()
+    {
+        return (int) NumParameters;
+    }
+    
+    constexpr const ParameterSpec& operator[] (int index) const
+    {
+        return parameters[(size_t) index];
+    }
+    
+    /** the index of the named parameter, or -1 if there is not one */
+    constexpr int indexOf(std::string_view name) const
+    {
+        for (size_t i = 0; i < NumParameters; i++)
+            if (parameters[i].name == name)
+                return (int) i;
+        
+        return -1;
+    }
+};
+
+template <typename... Specs>
+constexpr auto makeParameterSchema(Specs... specs)
+{
+    return ParameterSchema<sizeof...(Specs)> { { specs... } };
+}
+
+/**
+ The current values of a module's parameters, one atomic per parameter in
+ schema order. Written on the audio thread as changes and modulation arrive,
+ and safe to read from any thread
+ */
+class ParameterValues
+{
+    public:
+    
+    void setSize(int numParameters)
+    {
+        values = std::make_unique<std::atomic<float>[]>((size_t) numParameters);
+        numValues = numParameters;
+    }
+    
+    int size() const
+    {
+        return numValues;
+    }
+    
+    std::atomic<float>& operator[] (int index)
+    {
+        jassert(juce::isPositiveAndBelow(index, numValues));
+        return values[(size_t) index];
+    }
+    
+    float get(int index) const
+    {
+        jassert(juce::isPositiveAndBelow(index, numValues));
+        return values[(size_t) index].load(std::memory_order_relaxed);
+    }
+    
+    int getInt(int index) const
+    {
+        return juce::roundToInt(get(index));
+    }
+    
+    bool getBool(int index) const
+    {
+        return get(index) > 0.5f;
+    }
+    
+    private:
+    
+    std::unique_ptr<std::atomic<float>[]> values;
+    int numValues = 0;
+};
+    
+} //end namespace sketchbook
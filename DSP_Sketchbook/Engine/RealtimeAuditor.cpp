@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    RealtimeAuditor.cpp
+    Created: 16 Oct 2026 11:20:41am
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "RealtimeAuditor.h"
+
+namespace sketchbook
+{
+
+#if SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS
+
+namespace
+{
+thread_local bool isInRealtimeSection = false;
+
+std::atomic<int> numViolations { 0 };
+std::atomic<size_t> lastViolationSize { 0 };
+std::atomic<RealtimeAuditor::ViolationAction> violationAction { RealtimeAuditor::ViolationAction::assertion };
+}
+
+RealtimeAuditor::ScopedRealtimeSection::ScopedRealtimeSection()
+: wasInRealtimeSection(isInRealtimeSection)
+{
+    isInRealtimeSection = true;
+}
+
+RealtimeAuditor::ScopedRealtimeSection::~ScopedRealtimeSection()
+{
+    isInRealtimeSection = wasInRealtimeSection;
+}
+
+RealtimeAuditor::ScopedSuspend::ScopedSuspend()
+: wasInRealtimeSection(isInRealtimeSection)
+{
+    isInRealtimeSection = false;
+}
+
+RealtimeAuditor::ScopedSuspend::~ScopedSuspend()
+{
+    isInRealtimeSection = wasInRealtimeSection;
+}
+
+void RealtimeAuditor::allocationMade(size_t size)
+{
+    if (!isInRealtimeSection)
+        return;
+    
+    numViolations++;
+    lastViolationSize = size;
+    
+    //reporting may itself allocate, so stop auditing while it runs
+    ScopedSuspend suspend;
+    
+    if (violationAction == ViolationAction::logMessage)
+    {
+        juce::Logger::writeToLog("Real-time allocation of " + juce::String((juce::int64) size) + " bytes");
+    }
+    else
+    {
+        //something allocated on the audio thread - check the call stack
+        jassertfalse;
+    }
+}
+
+void RealtimeAuditor::setViolationAction(ViolationAction action)
+{
+    violationAction = action;
+}
+
+int RealtimeAuditor::getNumViolations()
+{
+    return numViolations;
+}
+
+size_t RealtimeAuditor::getLastViolationSize()
+{
+    return lastViolationSize;
+}
+
+void RealtimeAuditor::resetViolations()
+{
+    numViolations = 0;
+    lastViolationSize = 0;
+}
+
+#else
+
+void RealtimeAuditor::setViolationAction(ViolationAction) {}
+
+int RealtimeAuditor::getNumViolations()
+{
+    return 0;
+}
+
+size_t RealtimeAuditor::getLastViolationSize()
+{
+    return 0;
+}
+
+void RealtimeAuditor::resetViolations() {}
+
+#endif
+    
+} //end namespace sketchbook
+
+#if SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS
+//==============================================================================
+// Global allocation hooks. The nothrow forms of new forward to these by default,
+// aligned allocations are not audited
+void* operator new (std::size_t size)
+{
+    sketchbook::RealtimeAuditor::allocationMade(size);
+    
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[] (void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete (void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[] (void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    RealtimeAuditor.h
+    Created: 16 Oct 2026 11:20:41am
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ Catches heap allocations made on the audio thread.
+ 
+ When SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS is enabled the global operator new
+ is replaced, and any allocation made by a thread that is inside a
+ ScopedRealtimeSection is counted and then either asserted on or logged. When the
+ flag is disabled all of this compiles away to nothing.
+ */
+class RealtimeAuditor
+{
+    public:
+    
+    enum class ViolationAction
+    {
+        assertion, logMessage
+    };
+    
+    /**
+     Marks the calling thread as real-time for the lifetime of this object
+     */
+    struct ScopedRealtimeSection
+    {
+       #if SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS
+        ScopedRealtimeSection();
+        ~ScopedRealtimeSection();
+        
+        private:
+        bool wasInRealtimeSection;
+       #else
+        ScopedRealtimeSection() {}
+       #endif
+    };
+    
+    /**
+     Allocations made inside this scope are not reported, use it sparingly for
+     deliberate allocations such as the auditor's own logging
+     */
+    struct ScopedSuspend
+    {
+       #if SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS
+        ScopedSuspend();
+        ~ScopedSuspend();
+        
+        private:
+        bool wasInRealtimeSection;
+       #else
+        ScopedSuspend() {}
+       #endif
+    };
+    
+    static void setViolationAction(ViolationAction action);
+    
+    /** the number of allocations seen inside a real-time section since the last reset */
+    static int getNumViolations();
+    
+    /** the size in bytes of the most recent violating allocation */
+    static size_t getLastViolationSize();
+    
+    static void resetViolations();
+    
+    static bool isEnabled()
+    {
+        return SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS != 0;
+    }
+   
+   #if SKETCHBOOK_AUDIT_REALTIME_ALLOCATIONS
+    /** called by the operator new replacement */
+    static void allocationMade(size_t size);
+   #endif
+};
+    
+} //end namespace sketchbook
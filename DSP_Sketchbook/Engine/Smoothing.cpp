@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    Smoothing.cpp
+    Created: 16 Oct 2026 8:31:47pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "Smoothing.h"
+
+namespace sketchbook
+{
+
+void BlockRamp::multiply(float* data, int numSamples) const
+{
+    if (isConstant())
+    {
+        juce::FloatVectorOperations::multiply(data, start, numSamples);
+        return;
+    }
+    
+    //computed from the index rather than accumulated, so that the loop vectorises
+    const float increment = (end - start) / float(numSamples);
+    
+    for (int i = 0; i < numSamples; i++)
+        data[i] *= start + increment * float(i);
+}
+
+void BlockRamp::addWithMultiply(float* dest, const float* source, int numSamples) const
+{
+    if (isConstant())
+    {
+        juce::FloatVectorOperations::addWithMultiply(dest, source, start, numSamples);
+        return;
+    }
+    
+    const float increment = (end - start) / float(numSamples);
+    
+    for (int i = 0; i < numSamples; i++)
+        dest[i] += source[i] * (start + increment * float(i));
+}
+
+//==============================================================================
+void BlockSmoother::prepare(double sampleRate, double rampLengthSeconds)
+{
+    rampLengthSamples = juce::roundToInt(sampleRate * rampLengthSeconds);
+    setCurrentAndTarget(target);
+}
+
+void BlockSmoother::setCurrentAndTarget(float value)
+{
+    current = target = value;
+    step = 0.f;
+    samplesRemaining = 0;
+}
+
+void BlockSmoother::setTarget(float value)
+{
+    if (value == target)
+        return;
+    
+    if (rampLengthSamples <= 0)
+    {
+        setCurrentAndTarget(value);
+        return;
+    }
+    
+    target = value;
+    samplesRemaining = rampLengthSamples;
+    step = (target - current) / float(samplesRemaining);
+}
+
+BlockRamp BlockSmoother::getNextRamp(int numSamples)
+{
+    const float start = current;
+    
+    if (samplesRemaining <= numSamples)
+    {
+        //the ramp finishes inside this block, hold the target for the rest of it
+        current = target;
+        samplesRemaining = 0;
+        
+        return { start, numSamples > 0 ? target : start };
+    }
+    
+    current += step * float(numSamples);
+    samplesRemaining -= numSamples;
+    
+    return { start, current };
+}
+
+//==============================================================================
+void FilterCoefficientTable::build(int _numEntries, const std::function<Coefficients::Ptr(float normalisedValue)>& makeCoefficients)
+{
+    jassert(_numEntries > 1);
+    
+    numEntries = _numEntries;
+    numCoefficients = (int) makeCoefficients(0.f)->coefficients.size();
+    table.assign((size_t) (numEntries * numCoefficients), 0.f);
+    
+    for (int i = 0; i < numEntries; i++)
+    {
+        auto coefficients = makeCoefficients(float(i) / float(numEntries - 1));
+        jassert((int) coefficients->coefficients.size() == numCoefficients);
+        
+        std::copy(coefficients->coefficients.begin(), coefficients->coefficients.end(),
+                  table.begin() + i * numCoefficients);
+    }
+}
+
+void FilterCoefficientTable::build(int _numEntries, Shape shape, double sampleRate, juce::NormalisableRange<float> frequencyRange, float q)
+{
+    build(_numEntries, [&] (float normalisedValue) -> Coefficients::Ptr
+    {
+        const float frequency = frequencyRange.convertFrom0to1(normalisedValue);
+        
+        switch (shape)
+        {
+            case Shape::firstOrderLowPass:  return Coefficients::makeFirstOrderLowPass(sampleRate, frequency);
+            case Shape::firstOrderHighPass: return Coefficients::makeFirstOrderHighPass(sampleRate, frequency);
+            case Shape::lowPass:            return Coefficients::makeLowPass(sampleRate, frequency, q);
+            case Shape::highPass:           return Coefficients::makeHighPass(sampleRate, frequency, q);
+            case Shape::bandPass:           return Coefficients::makeBandPass(sampleRate, frequency, q);
+        }
+        
+        return Coefficients::makeFirstOrderLowPass(sampleRate, frequency);
+    });
+}
+
+void FilterCoefficientTable::lookup(float normalisedValue, Coefficients& dest) const
+{
+    jassert(!isEmpty());
+    jassert((int) dest.coefficients.size() == numCoefficients);
+    
+    const float position = juce::jlimit(0.f, 1.f, normalisedValue) * float(numEntries - 1);
+    const int index = juce::jmin((int) position, numEntries - 2);
+    const float proportion = position - float(index);
+    
+    const float* lower = table.data() + index * numCoefficients;
+    const float* upper = lower + numCoefficients;
+    float* coefficients = dest.getRawCoefficients();
+    
+    //the entries are close enough together that blending them keeps the filter stable
+    for (int i = 0; i < numCoefficients; i++)
+        coefficients[i] = lower[i] + (upper[i] - lower[i]) * proportion;
+}
+    
+} //end namespace sketchbook
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    Smoothing.h
+    Created: 16 Oct 2026 8:31:47pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ A linear ramp across one block, from start at the first sample towards end,
+ which is reached on the sample after the block
+ */
+struct BlockRamp
+{
+    float start = 0.f;
+    float end = 0.f;
+    
+    bool isConstant() const
+    {
+        return start == end;
+    }
+    
+    /** how far the ramp moves per sample over a block of numSamples */
+    float getIncrement(int numSamples) const
+    {
+        return numSamples > 0 ? (end - start) / float(numSamples) : 0.f;
+    }
+    
+    /** data *= ramp */
+    void multiply(float* data, int numSamples) const;
+    
+    /** dest += source * ramp */
+    void addWithMultiply(float* dest, const float* source, int numSamples) const;
+};
+
+//==============================================================================
+/**
+ Smooths a parameter towards its target a block at a time. Unlike
+ juce::SmoothedValue, which steps once per sample, the value is advanced once
+ per block and handed out as a BlockRamp, so it can be applied to every
+ channel with vector operations, or used to update coefficients once per block
+ */
+class BlockSmoother
+{
+    public:
+    
+    /** the time taken to reach a new target */
+    void prepare(double sampleRate, double rampLengthSeconds);
+    
+    /** jumps straight to a value */
+    void setCurrentAndTarget(float value);
+    
+    void setTarget(float value);
+    
+    float getTarget() const
+    {
+        return target;
+    }
+    
+    float getCurrentValue() const
+    {
+        return current;
+    }
+    
+    bool isSmoothing() const
+    {
+        return samplesRemaining > 0;
+    }
+    
+    /** the ramp over the next numSamples, which moves the value on */
+    BlockRamp getNextRamp(int numSamples);
+    
+    private:
+    
+    float current = 0.f;
+    float target = 0.f;
+    float step = 0.f;
+    int samplesRemaining = 0;
+    int rampLengthSamples = 0;
+};
+
+//==============================================================================
+/**
+ Pre-computed filter coefficients, indexed by a normalised parameter value.
+ 
+ Making juce::dsp::IIR::Coefficients allocates, so a parameter that moves a
+ filter cannot rebuild them on the audio thread. The table is built once in
+ prepareToPlay and lookup() interpolates between neighbouring entries,
+ writing into a coefficients object that was allocated up front, usually the
+ one the filter already holds.
+ */
+class FilterCoefficientTable
+{
+    public:
+    
+    using Coefficients = juce::dsp::IIR::Coefficients<float>;
+    
+    enum class Shape
+    {
+        firstOrderLowPass = 0, firstOrderHighPass, lowPass, highPass, bandPass
+    };
+    
+    /** builds the table with a function that is given values from 0 to 1, allocates */
+    void build(int numEntries, const std::function<Coefficients::Ptr(float normalisedValue)>& makeCoefficients);
+    
+    /** builds the table for one of the common shapes over a range of frequencies, allocates */
+    void build(int numEntries, Shape shape, double sampleRate, juce::NormalisableRange<float> frequencyRange, float q = 0.7071f);
+    
+    /** writes the coefficients for a normalised value into dest, which must have the same order as the table */
+    void lookup(float normalisedValue, Coefficients& dest) const;
+    
+    bool isEmpty() const
+    {
+        return numEntries == 0;
+    }
+    
+    private:
+    
+    std::vector<float> table;
+    int numEntries = 0;
+    int numCoefficients = 0;
+};
+    
+} //end namespace sketchbook
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    VoiceLanes.h
+    Created: 16 Oct 2026 4:12:55pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include "Smoothing.h"
+
+#if JUCE_USE_SIMD && SKETCHBOOK_ENABLE_VOICE_LANES
+ #define SKETCHBOOK_VOICE_LANES 1
+#else
+ #define SKETCHBOOK_VOICE_LANES 0
+#endif
+
+namespace sketchbook
+{
+
+/**
+ Helpers for processing several voices in lock-step, one voice per SIMD lane.
+ 
+ A module opts in by providing a static function
+     
+     static void processLanes(ModuleType* const* modules, int numModules,
+                              float* output, int numSamples);
+ 
+ which renders up to numLanes instances of the module at once. Each instance's
+ state is gathered into a lane at the start of the block and written back at
+ the end. The output is interleaved, sample i of module k is written to
+ output[i * numLanes + k], and output is SIMD aligned. Lanes past numModules
+ should be silent.
+ */
+struct VoiceLanes
+{
+   #if SKETCHBOOK_VOICE_LANES
+    using Register = juce::dsp::SIMDRegister<float>;
+    using Mask = Register::vMaskType;
+    
+    static constexpr int numLanes = (int) Register::SIMDNumElements;
+    
+    /** picks a where the mask is set and b elsewhere */
+    static Register select(Mask mask, Register a, Register b)
+    {
+        return (a & mask) + (b & ~mask);
+    }
+    
+    /** wraps values in the range [0, 2) back into [0, 1) */
+    static Register wrapUnit(Register x)
+    {
+        const auto one = Register::expand(1.f);
+        return x - (one & Register::greaterThanOrEqual(x, one));
+    }
+    
+    /**
+     sin(2 pi x) for x in [0, 1]. The phase is folded into a quarter cycle
+     for the same polynomial as FastMath::sin2Pi
+     */
+    static Register sin2Pi(Register x)
+    {
+        const auto half    = Register::expand(0.5f);
+        const auto quarter = Register::expand(0.25f);
+        
+        //into [-0.5, 0.5)
+        x = x - (Register::expand(1.f) & Register::greaterThanOrEqual(x, half));
+        
+        //then fold into [-0.25, 0.25]
+        x = select(Register::greaterThan(x, quarter), half - x, x);
+        x = select(Register::lessThan(x, Register::expand(-0.25f)), Register::expand(-0.5f) - x, x);
+        
+        return FastMath::sin2PiQuarter<FastMath::Accuracy::high>(x);
+    }
+    
+    /**
+     Interleaves one buffer per lane into dest, numLanes values per sample, so
+     each sample can then be read with one aligned vector load. Lanes with no
+     buffer follow their ramp instead, which runs across rampLength samples
+     */
+    static void interleave(const float* const* sources, const BlockRamp* ramps, int rampLength,
+                           int startSample, int numSamples, float* dest)
+    {
+        for (int k = 0; k < numLanes; k++)
+        {
+            const float* source = sources[k];
+            
+            if (source == nullptr)
+            {
+                const BlockRamp& ramp = ramps[k];
+                const float increment = ramp.getIncrement(rampLength);
+                
+                for (int i = 0; i < numSamples; i++)
+                    dest[i * numLanes + k] = ramp.start + increment * float(startSample + i);
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; i++)
+                    dest[i * numLanes + k] = source[startSample + i];
+            }
+        }
+    }
+   #else
+    static constexpr int numLanes = 1;
+   #endif
+};
+
+//==============================================================================
+/** true for module types that provide processLanes */
+template <typename ModuleType, typename = void>
+struct hasVoiceLanes : std::false_type {};
+
+#if SKETCHBOOK_VOICE_LANES
+template <typename ModuleType>
+struct hasVoiceLanes<ModuleType, std::void_t<decltype(ModuleType::processLanes(std::declval<ModuleType* const*>(), 0,
+                                                                                 std::declval<float*>(), 0))>>
+    : std::true_type {};
+#endif
+    
+} //end namespace sketchbook
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    VoiceThreadPool.cpp
+    Created: 16 Oct 2026 1:42:17pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "VoiceThreadPool.h"
+#include "RealtimeAuditor.h"
+
+namespace sketchbook
+{
+
+VoiceThreadPool::VoiceThreadPool(int numWorkerThreads)
+{
+    for (int i = 0; i < numWorkerThreads; i++)
+    {
+        workers.push_back(std::make_unique<Worker>(*this, i + 1));
+        workers.back()->startRealtimeThread(juce::Thread::RealtimeOptions{});
+    }
+}
+
+VoiceThreadPool::~VoiceThreadPool()
+{
+    for (auto& worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->notify();
+    }
+    
+    for (auto& worker : workers)
+        worker->stopThread(1000);
+}
+
+int VoiceThreadPool::getNumWorkers() const
+{
+    return (int) workers.size() + 1;
+}
+
+void VoiceThreadPool::run(Job& job, int numJobs, int numThreadsToUse)
+{
+    const int numWorkersToWake = juce::jlimit(0, (int) workers.size(), juce::jmin(numThreadsToUse, numJobs) - 1);
+    
+    currentJob = &job;
+    numCurrentJobs = numJobs;
+    nextJobIndex.store(0, std::memory_order_relaxed);
+    numBusyWorkers.store(numWorkersToWake, std::memory_order_release);
+    
+    for (int i = 0; i < numWorkersToWake; i++)
+        workers[(size_t) i]->wake();
+    
+    runAvailableJobs(0);
+    
+    //every job is now claimed, anyone still asleep has nothing left to do
+    for (int i = 0; i < numWorkersToWake; i++)
+        if (workers[(size_t) i]->cancelIfNotStarted())
+            numBusyWorkers.fetch_sub(1, std::memory_order_acq_rel);
+    
+    //wait for the jobs that other workers are part way through
+    while (numBusyWorkers.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+    
+    currentJob = nullptr;
+}
+
+void VoiceThreadPool::runAvailableJobs(int workerIndex)
+{
+    for (;;)
+    {
+        const int jobIndex = nextJobIndex.fetch_add(1, std::memory_order_acq_rel);
+        
+        if (jobIndex >= numCurrentJobs)
+            return;
+        
+        currentJob->runJob(jobIndex, workerIndex);
+    }
+}
+
+//==============================================================================
+VoiceThreadPool::Worker::Worker(VoiceThreadPool& owner, int workerIndex)
+: juce::Thread("Sketchbook Voice Worker " + juce::String(workerIndex)),
+  pool(owner),
+  index(workerIndex)
+{
+}
+
+void VoiceThreadPool::Worker::run()
+{
+    int numSpins = 0;
+    
+    while (!threadShouldExit())
+    {
+        if (hasWork.exchange(false, std::memory_order_acq_rel))
+        {
+            {
+                RealtimeAuditor::ScopedRealtimeSection realtimeSection;
+                pool.runAvailableJobs(index);
+            }
+            
+            pool.numBusyWorkers.fetch_sub(1, std::memory_order_acq_rel);
+            numSpins = 0;
+        }
+        else if (++numSpins < numSpinsBeforeSleep)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            wait(100);
+            numSpins = 0;
+        }
+    }
+}
+
+void VoiceThreadPool::Worker::wake()
+{
+    hasWork.store(true, std::memory_order_release);
+    notify();
+}
+
+bool VoiceThreadPool::Worker::cancelIfNotStarted()
+{
+    return hasWork.exchange(false, std::memory_order_acq_rel);
+}
+    
+} //end namespace sketchbook
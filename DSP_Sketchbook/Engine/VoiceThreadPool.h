@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    VoiceThreadPool.h
+    Created: 16 Oct 2026 1:42:17pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace sketchbook
+{
+
+/**
+ A small pool of real-time worker threads used to render voices in parallel.
+ 
+ The thread that calls run() always takes part as worker 0, the pool threads
+ are numbered from 1. Jobs are handed out from a shared atomic counter so a
+ worker that finishes early simply takes the next unclaimed job. run() does
+ not allocate or lock, workers that have not woken by the time every job is
+ claimed are skipped rather than waited for.
+ */
+class VoiceThreadPool
+{
+    public:
+    
+    struct Job
+    {
+        virtual ~Job() = default;
+        
+        /** called once for every index in the range passed to run */
+        virtual void runJob(int jobIndex, int workerIndex) = 0;
+    };
+    
+    VoiceThreadPool(int numWorkerThreads);
+    
+    ~VoiceThreadPool();
+    
+    /** the number of threads that may run jobs, including the calling thread */
+    int getNumWorkers() const;
+    
+    /**
+     Runs jobs 0 to numJobs - 1 over the calling thread and up to
+     numThreadsToUse - 1 pool threads, returning once all have finished
+     */
+    void run(Job& job, int numJobs, int numThreadsToUse);
+    
+    private:
+    
+    class Worker : public juce::Thread
+    {
+        public:
+        
+        Worker(VoiceThreadPool& owner, int workerIndex);
+        
+        void run() override;
+        
+        void wake();
+        
+        //returns true if the worker had not yet picked up its work
+        bool cancelIfNotStarted();
+        
+        private:
+        
+        VoiceThreadPool& pool;
+        const int index;
+        std::atomic<bool> hasWork { false };
+    };
+    
+    void runAvailableJobs(int workerIndex);
+    
+    std::vector<std::unique_ptr<Worker>> workers;
+    
+    Job* currentJob = nullptr;
+    int numCurrentJobs = 0;
+    std::atomic<int> nextJobIndex { 0 };
+    std::atomic<int> numBusyWorkers { 0 };
+    
+    //how many times an idle worker checks for work before going to sleep,
+    //blocks split by midi events tend to arrive in quick succession
+    static constexpr int numSpinsBeforeSleep = 512;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceThreadPool)
+};
+    
+} //end namespace sketchbook
@@ -11,6 +11,10 @@
 #pragma once
 #include <JuceHeader.h>
 #include "Module.h"
+#include "VoiceThreadPool.h"
+#include "MidiScheduler.h"
+#include "VoiceLanes.h"
+#include "FastMath.h"
 #include "../Modules/EnvelopeModule.h"
 
 namespace sketchbook
@@ -69,7 +73,7 @@ private:
     
     float getPitchHertz(float noteNumber)
     {
-        return 440.f * std::pow (2.f, (noteNumber - 69.f) / 12.f);
+        return 440.f * FastMath::exp2((noteNumber - 69.f) / 12.f);
     }
     
     void setStartEnd(int startNum, int targetNoteNumber)
@@ -111,6 +115,89 @@ private:
     float m_timeInSeconds  = 0.3f;
 };
 
+/**
+ Where the control rate ticks fall relative to a block. Modulation sources are
+ evaluated once per tick rather than for every sample, see Voice::processGroup
+ */
+struct ControlClock
+{
+    int samplesPerTick = 32;
+    
+    /** from the start of the block, 0 means a tick is due on the first sample */
+    int samplesUntilTick = 0;
+    
+    /** moves the clock on past a block of numSamples */
+    void advance(int numSamples)
+    {
+        samplesUntilTick = (samplesUntilTick - numSamples) % samplesPerTick;
+        
+        if (samplesUntilTick < 0)
+            samplesUntilTick += samplesPerTick;
+    }
+};
+
+/**
+ Decides when a voice has gone quiet. It is fed the level of each stretch the
+ voice renders and reports silence once the level has stayed at or below the
+ threshold for the hold time, so a zero crossing in a short stretch is not
+ mistaken for the end of the note
+ */
+struct SilenceDetector
+{
+    /** the rms level, as a gain, below which the voice counts as silent */
+    float threshold = 0.001f;
+    int holdSamples = 0;
+    int numSilentSamples = 0;
+    
+    /** returns true once the voice has been silent for the hold time */
+    bool update(float rmsLevel, int numSamples)
+    {
+        if (rmsLevel > threshold)
+            numSilentSamples = 0;
+        else
+            numSilentSamples += numSamples;
+        
+        return numSilentSamples >= holdSamples;
+    }
+    
+    void reset()
+    {
+        numSilentSamples = 0;
+    }
+};
+
+/**
+ Working buffers used while rendering a voice. There is one of these per render
+ thread rather than per voice, so voices rendered in parallel never share one
+ */
+struct VoiceScratch
+{
+    void prepare(int buffersize)
+    {
+        tmpBuffer.setSize(1, buffersize);
+        fadeBuffer.setSize(1, buffersize);
+        
+        //one voice envelope per lane, and room to align the interleaved lane output
+        adsrBuffer.setSize(VoiceLanes::numLanes, buffersize);
+        laneData.allocate((size_t) (VoiceLanes::numLanes * (buffersize + 1)), true);
+    }
+    
+    /** interleaved output for modules rendered in SIMD lanes, see VoiceLanes */
+    float* getLaneBuffer()
+    {
+       #if SKETCHBOOK_VOICE_LANES
+        return VoiceLanes::Register::getNextSIMDAlignedPtr(laneData.get());
+       #else
+        return laneData.get();
+       #endif
+    }
+    
+    juce::AudioBuffer<float> tmpBuffer;
+    juce::AudioBuffer<float> fadeBuffer;
+    juce::AudioBuffer<float> adsrBuffer;
+    juce::HeapBlock<float> laneData;
+};
+
 template<typename Modules, typename ModSources>
 class Voice : public juce::ValueTree::Listener
 {
@@ -132,20 +219,27 @@ class Voice : public juce::ValueTree::Listener
     }
     
     //==============================================================================
-    void prepare (float samplerate, int buffersize)
+    /** modules render in mono, the voice pans them onto a bus of numChannels */
+    void prepare (float samplerate, int buffersize, int numChannels = 2)
     {
         moduleList.forEach([&] (auto& mod, auto)
         {
             mod.prepareToPlay(samplerate, buffersize);
+            mod.prepareModulation(buffersize, false);
+            mod.prepareEnableFade(samplerate, buffersize);
         });
         
         modulationSourceList.forEach([&] (auto& mod, auto)
         {
             mod.prepareToPlay(samplerate, buffersize);
+            mod.prepareModulation(buffersize, true);
         });
         
         voiceEnvelope.prepareToPlay(samplerate, buffersize);
         portaController.prepare(samplerate);
+        
+        //sized here so that process never allocates
+        outputBuffer.setSize(juce::jmax(1, numChannels), buffersize);
     }
     
     //==============================================================================
@@ -153,6 +247,10 @@ class Voice : public juce::ValueTree::Listener
     {
         moduleList.forEach([&] (auto& mod, auto)
         {
+            //the fade only moves while the voice renders, so one left over from while it was idle would play now
+            if (!m_isPlaying)
+                mod.skipEnableFade();
+            
             mod.noteOn(event);
         });
         
@@ -164,6 +262,14 @@ class Voice : public juce::ValueTree::Listener
         voiceEnvelope.noteOn(event);
         
         portaController.noteOn(event);
+        silenceDetector.reset();
+        
+        //restarted sources are caught up with the control clock on the next block
+        if (!event.isLegatoNoteOn)
+        {
+            controlTickPending = true;
+            sourceBehindClock.fill(true);
+        }
         
         noteOnMessage = event.midiMessage;
         m_isPlaying = true;
@@ -202,74 +308,148 @@ class Voice : public juce::ValueTree::Listener
         voiceEnvelope.applyMidi(message);
     }
     
-    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    /**
+     Renders the voice into its own output buffer, see getOutputBuffer. This
+     only touches state owned by the voice and the scratch, so different voices
+     may be processed on different threads at the same time
+     */
+    void process(VoiceScratch& scratch, int startSample, int numSamples, ControlClock clock = {})
     {
-        if (tmpBuffer.getNumSamples() != buffer.getNumSamples()
-            || tmpBuffer.getNumChannels() != buffer.getNumChannels())
-        {
-            tmpBuffer.setSize(buffer.getNumChannels(), buffer.getNumSamples());
-        }
+        Voice* self = this;
+        processGroup(&self, 1, scratch, startSample, numSamples, clock);
+    }
+    
+    /**
+     Renders up to VoiceLanes::numLanes voices in lock-step. Each module is run
+     for every voice in the group before moving on to the next module, so that
+     modules providing processLanes can render the whole group in one pass.
+     Voices rendered alone go through the same path, so a voice sounds the
+     same whichever group it lands in.
+     
+     Modulation sources are only run on the ticks of the control clock, the
+     block is split at each tick and modulated parameters are ramped between
+     them, see Module::getParameterRamp. A source mapped to an audio rate
+     parameter is instead run per sample, the voice's other sources stay on
+     the control clock, see Module::setAudioRateModulation
+     */
+    static void processGroup(Voice* const* group, int numInGroup, VoiceScratch& scratch, int startSample, int numSamples,
+                             ControlClock clock = {})
+    {
+        jassert(numInGroup > 0 && numInGroup <= VoiceLanes::numLanes);
+        jassert(clock.samplesUntilTick >= 0 && clock.samplesUntilTick <= clock.samplesPerTick);
         
-        float freqHz = portaController.getNextPitch(numSamples);
-        //DBG(freqHz);
+        for (int g = 0; g < numInGroup; g++)
+            group[g]->beginBlock(scratch, startSample, numSamples);
         
-        //calculate any mapped parameters
-        modulationSourceList.forEach([&] (auto& mod, auto)
-                                     {
-            //TODO: this is a bit of a waste of processing - the whole
-            //TODO: modulation buffer is processed when only the last
-            //TODO: sample will be used
-            for (int i = startSample; i < startSample + numSamples; i++)
-            {
-                float dummyFloat = 1.f;
-                mod.processSample(&dummyFloat);
-            }
-            
-            //modulation source parameters may themselves be modulated
-            mod.pitchUpdated(freqHz);
-            mod.runModulations();
-        });
+        const int endSample = startSample + numSamples;
         
-        //pre calc the voice env multiplicative buffer
-        juce::AudioBuffer<float> adsrBuffer(1, buffer.getNumSamples());
-        for (int i = startSample; i < startSample + numSamples; i++)
+        //voices that have just started bring their sources up to the next tick
+        if (clock.samplesUntilTick > 0)
         {
-            adsrBuffer.getWritePointer(0)[i] = 1.f;
-            getVoiceADSR()->processSample(adsrBuffer.getWritePointer(0) + i);
+            const int tickSample = juce::jmin(startSample + clock.samplesUntilTick, endSample) - 1;
+            
+            for (int g = 0; g < numInGroup; g++)
+                if (group[g]->controlTickPending)
+                    group[g]->runControlTick(clock.samplesUntilTick, tickSample, true);
         }
         
-        //TODO: stereo processing
-        moduleList.forEach([&] (auto& mod, auto)
+        for (int chunkStart = startSample; chunkStart < endSample;)
         {
-            if (!mod.isModuleEnabled()) return;
-            
-            mod.pitchUpdated(freqHz);
-            mod.runModulations();
-            tmpBuffer.clear();
-            
-            for (int i = startSample; i < startSample + numSamples; i++)
+            if (clock.samplesUntilTick == 0)
             {
-                mod.processSample(tmpBuffer.getWritePointer(0)+i);
+                //sources run per sample are read where the tick lands, or at the end of the block if it is further
+                const int tickSample = juce::jmin(chunkStart + clock.samplesPerTick, endSample) - 1;
+                
+                for (int g = 0; g < numInGroup; g++)
+                    group[g]->runControlTick(clock.samplesPerTick, tickSample, false);
+                
+                clock.samplesUntilTick = clock.samplesPerTick;
             }
             
-            //if uses the voice env then apply the voice env
-            if (mod.getVoiceMonitorType() == Module::VoiceMonitorType::adsr)
-            {
-                for (int i = startSample; i < startSample + numSamples; i++)
-                {
-                    tmpBuffer.getWritePointer(0)[i] *= adsrBuffer.getWritePointer(0)[i];
-                }
-            }
+            const int chunkSize = juce::jmin(clock.samplesUntilTick, endSample - chunkStart);
             
-            for (int i = startSample; i < startSample + numSamples; i++)
-            {
-                buffer.getWritePointer(0)[i] += tmpBuffer.getWritePointer(0)[i];
-            }
-        });
+            //where the chunk lies along the ramp between the last two ticks
+            const int samplesIntoTick = clock.samplesPerTick - clock.samplesUntilTick;
+            const float startOfChunk = float(samplesIntoTick) / float(clock.samplesPerTick);
+            const float endOfChunk = float(samplesIntoTick + chunkSize) / float(clock.samplesPerTick);
+            
+            renderChunk(group, numInGroup, scratch, chunkStart, chunkSize, startOfChunk, endOfChunk);
+            
+            chunkStart += chunkSize;
+            clock.samplesUntilTick -= chunkSize;
+        }
         
-        //if both the adsr and silence detector return true then we can clear the note
-        if (checkVoiceEnvelope() && runSilenceDetector(buffer))
-            m_isPlaying = false;
+        for (int g = 0; g < numInGroup; g++)
+            group[g]->endBlock(startSample, numSamples);
+    }
+    
+    /**
+     Ramps the voice down to silence over numSamples and then stops it, used
+     when a voice is stolen so that it does not click
+     */
+    void startFadeOut(int numSamples)
+    {
+        if (isFadingOut())
+            return;
+        
+        fadeOutStep = 1.f / float(juce::jmax(1, numSamples));
+        fadeOutGain = 1.f - fadeOutStep;
+    }
+    
+    bool isFadingOut() const
+    {
+        return fadeOutGain < 1.f;
+    }
+    
+    float getFadeOutGain() const
+    {
+        return fadeOutGain;
+    }
+    
+    /**
+     Where the voice sits in the stereo field, from -1 (left) to 1 (right). The
+     first two channels of the bus are panned with an equal power law, further
+     channels repeat the left and right gains in pairs
+     */
+    void setPan(float newPan)
+    {
+        if (newPan == pan)
+            return;
+        
+        pan = newPan;
+        
+        const float angle = (pan + 1.f) * juce::MathConstants<float>::pi * 0.25f;
+        panGains = { std::cos(angle), std::sin(angle) };
+    }
+    
+    /** the voice's place in the stereo spread, from -1 to 1, see VoiceController::setStereoSpread */
+    void setSpreadOffset(float offset)
+    {
+        spreadOffset = offset;
+    }
+    
+    float getSpreadOffset() const
+    {
+        return spreadOffset;
+    }
+    
+    /** see VoiceController::setSilenceThreshold */
+    void setSilenceDetection(float thresholdGain, int holdSamples)
+    {
+        silenceDetector.threshold = thresholdGain;
+        silenceDetector.holdSamples = holdSamples;
+    }
+    
+    /** the peak level of the last block rendered */
+    float getLevel() const
+    {
+        return lastPeakLevel;
+    }
+    
+    /** holds the output of the last call to process */
+    const juce::AudioBuffer<float>& getOutputBuffer() const
+    {
+        return outputBuffer;
     }
     
     void reset()
@@ -289,6 +469,11 @@ class Voice : public juce::ValueTree::Listener
         m_isPlaying = false;
         m_isReleasing = false;
         noteOnMessage = juce::MidiMessage();
+        fadeOutGain = 1.f;
+        lastPeakLevel = 0.f;
+        silenceDetector.reset();
+        controlTickPending = true;
+        sourceBehindClock.fill(true);
     }
     
     EnvelopeModule* getVoiceADSR()
@@ -330,6 +515,35 @@ class Voice : public juce::ValueTree::Listener
         valueTreePropertyChanged(m_glideTimeParamData, Module::ParamIdents::VALUE);
     }
     
+    /** see Module::setParameterQueue */
+    void setParameterQueue(ParameterQueue* queue)
+    {
+        moduleList.forEach([&] (auto& mod, auto)
+        {
+            mod.setParameterQueue(queue);
+        });
+        
+        modulationSourceList.forEach([&] (auto& mod, auto)
+        {
+            mod.setParameterQueue(queue);
+        });
+        
+        voiceEnvelope.setParameterQueue(queue);
+        portaTimeSlot.setQueue(queue);
+    }
+    
+    /** points each module at its probe's counter, by module name */
+    void setProfiler(ModuleProfiler& profiler)
+    {
+        forEachModule([&] (Module& mod)
+        {
+            mod.setProfilerCounter(profiler.getCounter(profiler.getProbeId(mod.getNameInternal())));
+        });
+        
+        voiceEnvelope.setProfilerCounter(profiler.getCounter(profiler.getProbeId(voiceEnvelope.getNameInternal())));
+        modulationProfilerCounter = profiler.getCounter(profiler.getProbeId(ModuleProfiler::modulationProbeName));
+    }
+    
     bool isPlaying()
     {
         return m_isPlaying;
@@ -350,6 +564,14 @@ class Voice : public juce::ValueTree::Listener
         return noteOnMessage;
     }
     
+    /** calls fn for each module and then each modulation source, without allocating */
+    template <typename Fn>
+    void forEachModule(Fn&& fn)
+    {
+        moduleList.forEach([&] (auto& mod, auto) { fn(static_cast<Module&>(mod)); });
+        modulationSourceList.forEach([&] (auto& mod, auto) { fn(static_cast<Module&>(mod)); });
+    }
+    
     juce::Array<Module*> getModulesArray()
     {
         auto arr = moduleList.toArray();
@@ -363,210 +585,1204 @@ class Voice : public juce::ValueTree::Listener
     {
         if (property == Module::ParamIdents::VALUE)
         {
-            portaController.setPortamentoTime(float(tree[Module::ParamIdents::VALUE]));
+            portaTimeSlot.post(float(tree[Module::ParamIdents::VALUE]));
         }
     }
     
-    //returns true if the voice envelope is finished
-    bool checkVoiceEnvelope()
+    void beginBlock(VoiceScratch& scratch, int startSample, int numSamples)
     {
-        return !voiceEnvelope.isActive();
+        //the voice and scratch must be prepared with a block size at least as large as the buffer
+        jassert(startSample + numSamples <= outputBuffer.getNumSamples());
+        jassert(startSample + numSamples <= scratch.tmpBuffer.getNumSamples());
+        juce::ignoreUnused(scratch);
+        
+        outputBuffer.clear(startSample, numSamples);
+        currentFreqHz = portaController.getNextPitch(numSamples);
+        
+        //only the sources that feed an audio rate parameter are run per sample
+        modulationSourceList.forEach([&] (auto& source, auto index)
+        {
+            bool needsAudioRate = false;
+            
+            moduleList.forEach([&] (auto& mod, auto)
+            {
+                needsAudioRate = needsAudioRate || (mod.isModuleActive() && mod.hasAudioRateMappingFrom(&source));
+            });
+            
+            //the source picks the control clock back up where it is
+            if (source.isAudioRateSource() && !needsAudioRate)
+            {
+                sourceBehindClock[index] = true;
+                controlTickPending = true;
+            }
+            
+            source.setAudioRateSource(needsAudioRate);
+            
+            if (needsAudioRate)
+            {
+                ModuleProfiler::ScopedProbe probe(source.getProfilerCounter());
+                source.processModulationOutput(startSample, numSamples);
+                
+                //modulation source parameters may themselves be modulated
+                source.pitchUpdated(currentFreqHz);
+                source.runModulations();
+                
+                sourceBehindClock[index] = false;
+            }
+        });
     }
     
-    //returns true if the silence detector detects note finished
-    bool runSilenceDetector(juce::AudioBuffer<float>& outputBuffer)
+    void endBlock(int startSample, int numSamples)
     {
-        // silence detector
-        bool active = false;
-        for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch)
+        if (fadeOutGain < 1.f)
+            applyFadeOut(startSample, numSamples);
+        
+        //the level and silence detection share one pass over the voice's own output
+        const int numChannels = outputBuffer.getNumChannels();
+        float peak = 0.f;
+        float maxSumOfSquares = 0.f;
+        
+        for (int ch = 0; ch < numChannels; ch++)
         {
-            if (outputBuffer.getRMSLevel(ch, 0, outputBuffer.getNumSamples()) > 0.001f)
+            const auto* data = outputBuffer.getReadPointer(ch) + startSample;
+            float sumOfSquares = 0.f;
+            
+            for (int i = 0; i < numSamples; i++)
             {
-                active = true;
-                break;
+                peak = juce::jmax(peak, std::abs(data[i]));
+                sumOfSquares += data[i] * data[i];
             }
+            
+            maxSumOfSquares = juce::jmax(maxSumOfSquares, sumOfSquares);
         }
         
-        return !active;
+        lastPeakLevel = peak;
+        
+        //the loudest channel, so a voice panned hard to one side is not counted as quieter
+        const float rmsLevel = std::sqrt(maxSumOfSquares / float(juce::jmax(1, numSamples)));
+        const bool isSilent = silenceDetector.update(rmsLevel, numSamples);
+        
+        //if both the adsr and silence detector return true then we can clear the note
+        if (checkVoiceEnvelope() && isSilent)
+            m_isPlaying = false;
     }
     
-    //==============================================================================
-    juce::HeapBlock<char> heapBlock;
-    juce::dsp::AudioBlock<float> tempBlock;
-    juce::AudioBuffer<float> tmpBuffer;
-    
-    Modules moduleList;
-    ModSources modulationSourceList;
-    EnvelopeModule voiceEnvelope;
-    bool m_isPlaying=false;
-    bool m_isReleasing = false;
-    juce::MidiMessage noteOnMessage;
-    
-    juce::ValueTree m_glideTimeParamData;
-    PortamentoController portaController;
-};
-
-template<typename Modules, typename ModSources>
-class VoiceController : public juce::ValueTree::Listener
-{
-    using VoiceType = Voice<Modules, ModSources>;
-    const int numVoices = 32;
-    
-    juce::Array<std::shared_ptr<VoiceType>> voices;
-    std::shared_ptr<VoiceType> latestVoice;
-    
-    enum class ArticulationType
-    {
-        poly=0, mono, legato
-    };
-    
-    ArticulationType articulationType = ArticulationType::legato;
-    std::list<juce::MidiMessage> monoNoteHistory;
-    juce::ValueTree m_voiceModeData;
-    
-public:
-    
-    VoiceController()
+    /**
+     Advances the modulation sources by numSamples, to the next tick of the
+     control clock, and sets the targets that the modulated parameters ramp to.
+     Sources run per sample are read at tickSample. When catching up, only
+     the sources that are behind the clock are moved
+     */
+    void runControlTick(int numSamples, int tickSample, bool isCatchUp)
     {
-        for (int i = 0; i < numVoices; i++)
+        modulationSourceList.forEach([&] (auto& mod, auto index)
         {
-            voices.add(std::make_shared<VoiceType>());
-        }
+            //sources run per sample are already through the block, a catch up only moves those behind
+            if (mod.isAudioRateSource() || (isCatchUp && !sourceBehindClock[index]))
+                return;
+            
+            sourceBehindClock[index] = false;
+            
+            ModuleProfiler::ScopedProbe probe(mod.getProfilerCounter());
+            mod.processControl(numSamples);
+            
+            //modulation source parameters may themselves be modulated
+            mod.pitchUpdated(currentFreqHz);
+            mod.runModulations();
+        });
+        
+        ModuleProfiler::ScopedProbe probe(modulationProfilerCounter);
+        
+        //there is nothing to ramp from on the first tick of a note, modules that are
+        //switched off are skipped and come back in under their fade
+        moduleList.forEach([&] (auto& mod, auto)
+        {
+            if (mod.isModuleActive())
+                mod.updateModulationTargets(controlTickPending, tickSample);
+        });
+        
+        controlTickPending = false;
     }
     
-    virtual ~VoiceController() {}
-    
-    virtual void prepare(float sampleRate, int bufferSize)
+    /** renders a stretch of the block that lies between two control ticks */
+    static void renderChunk(Voice* const* group, int numInGroup, VoiceScratch& scratch, int startSample, int numSamples,
+                            float startOfChunk, float endOfChunk)
     {
-        for (auto voice : voices )
+        //pre calc the voice env multiplicative buffer
+        renderStage<EnvelopeModule>(group, numInGroup, scratch, startSample, numSamples, 1.f,
+                                    [] (Voice& v) -> EnvelopeModule& { return v.voiceEnvelope; },
+                                    [] (Voice&, EnvelopeModule&) { return true; },
+                                    [&] (Voice&, EnvelopeModule&, int g, float* src, int stride)
         {
-            voice->prepare(sampleRate, bufferSize);
-        }
+            auto* adsr = scratch.adsrBuffer.getWritePointer(g) + startSample;
+            
+            for (int i = 0; i < numSamples; i++)
+                adsr[i] = src[i * stride];
+        });
+        
+        group[0]->moduleList.forEach([&] (auto& firstMod, auto index)
+        {
+            using ModuleType = std::decay_t<decltype(firstMod)>;
+            constexpr size_t modIndex = decltype(index)::value;
+            
+            renderStage<ModuleType>(group, numInGroup, scratch, startSample, numSamples, 0.f,
+                                    [] (Voice& v) -> ModuleType& { return v.moduleList.template get<modIndex>(); },
+                                    [&] (Voice& v, ModuleType& mod)
+            {
+                if (!mod.isModuleActive()) return false;
+                
+                mod.pitchUpdated(v.currentFreqHz);
+                
+                ModuleProfiler::ScopedProbe probe(v.modulationProfilerCounter);
+                
+                mod.sendModulations(startOfChunk, endOfChunk, startSample, numSamples);
+                
+                return true;
+            },
+                                    [&] (Voice& v, ModuleType& mod, int g, float* src, int stride)
+            {
+                //if uses the voice env then apply the voice env
+                const bool useAdsr = mod.getVoiceMonitorType() == Module::VoiceMonitorType::adsr;
+                
+                const float* gain = useAdsr ? scratch.adsrBuffer.getReadPointer(g) + startSample : nullptr;
+                
+                //fading in or out after being switched on or off
+                if (mod.isEnableFading())
+                {
+                    auto* fade = scratch.fadeBuffer.getWritePointer(0) + startSample;
+                    
+                    juce::FloatVectorOperations::fill(fade, 1.f, numSamples);
+                    mod.getNextEnableRamp(numSamples).multiply(fade, numSamples);
+                    
+                    if (gain != nullptr)
+                        juce::FloatVectorOperations::multiply(fade, gain, numSamples);
+                    
+                    gain = fade;
+                }
+                
+                v.addToBus(src, stride, gain, startSample, numSamples);
+            });
+        });
     }
     
-    virtual void reset()
+    /**
+     Runs one module for each voice in a group. beforeRender returns false to
+     skip a voice, afterRender receives the module's output as a pointer and a
+     stride, which is 1 unless the module was rendered in SIMD lanes
+     */
+    template <typename ModuleType, typename GetModule, typename BeforeRender, typename AfterRender>
+    static void renderStage(Voice* const* group, int numInGroup, VoiceScratch& scratch, int startSample, int numSamples,
+                            float initialValue, GetModule&& getModule, BeforeRender&& beforeRender, AfterRender&& afterRender)
     {
-        for (auto voice : voices )
+        std::array<ModuleType*, (size_t) VoiceLanes::numLanes> modules;
+        std::array<int, (size_t) VoiceLanes::numLanes> groupIndex;
+        int numToRender = 0;
+        
+        for (int g = 0; g < numInGroup; g++)
+        {
+            auto& mod = getModule(*group[g]);
+            
+            if (beforeRender(*group[g], mod))
+            {
+                modules[(size_t) numToRender] = &mod;
+                groupIndex[(size_t) numToRender++] = g;
+            }
+        }
+        
+       #if SKETCHBOOK_VOICE_LANES
+        if constexpr (hasVoiceLanes<ModuleType>::value)
+        {
+            if (numToRender > 0)
+            {
+                auto* lanes = scratch.getLaneBuffer();
+                
+                {
+                    //every voice's module shares one probe, so the whole group is counted at once
+                    ModuleProfiler::ScopedProbe probe(modules[0]->getProfilerCounter());
+                    ModuleType::processLanes(modules.data(), numToRender, lanes, numSamples);
+                }
+                
+                for (int k = 0; k < numToRender; k++)
+                    afterRender(*group[groupIndex[(size_t) k]], *modules[(size_t) k], groupIndex[(size_t) k],
+                                lanes + k, VoiceLanes::numLanes);
+            }
+            
+            return;
+        }
+       #endif
+        
+        for (int k = 0; k < numToRender; k++)
         {
-            voice->reset();
+            auto* tmp = scratch.tmpBuffer.getWritePointer(0);
+            juce::FloatVectorOperations::fill(tmp + startSample, initialValue, numSamples);
+            
+            {
+                ModuleProfiler::ScopedProbe probe(modules[(size_t) k]->getProfilerCounter());
+                modules[(size_t) k]->processBlock(tmp, startSample, numSamples);
+            }
+            
+            afterRender(*group[groupIndex[(size_t) k]], *modules[(size_t) k], groupIndex[(size_t) k],
+                        tmp + startSample, 1);
         }
     }
     
-    virtual void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int numSamples)
+    /**
+     Adds a module's mono output, times gain if it is not null, to every channel
+     of the bus. A stereo bus is written in a single pass over the samples
+     */
+    void addToBus(const float* src, int stride, const float* gain, int startSample, int numSamples)
     {
-        auto prevSample = startSample;
-        const auto endSample = startSample + numSamples;
-
-        for (auto it = midiMessages.findNextSamplePosition (startSample); it != midiMessages.cend(); ++it)
+        const int numChannels = outputBuffer.getNumChannels();
+        
+        if (numChannels == 2)
         {
-            const auto metadata = *it;
-
-            if (metadata.samplePosition >= endSample)
-                break;
-
-            const auto smallBlockAllowed = (prevSample == startSample);
-            const auto thisBlockSize = smallBlockAllowed ? 1 : 32;
-
-            if (metadata.samplePosition >= prevSample + thisBlockSize)
+            auto* left  = outputBuffer.getWritePointer(0) + startSample;
+            auto* right = outputBuffer.getWritePointer(1) + startSample;
+            const float leftGain  = panGains[0];
+            const float rightGain = panGains[1];
+            
+            if (gain != nullptr)
             {
-                for (auto voice : voices)
+                for (int i = 0; i < numSamples; i++)
                 {
-                    if (voice->isPlaying())
-                        voice->process(buffer, prevSample, metadata.samplePosition - prevSample);
+                    const float sample = src[i * stride] * gain[i];
+                    left[i]  += sample * leftGain;
+                    right[i] += sample * rightGain;
                 }
-
-                prevSample = metadata.samplePosition;
             }
-
-            handleMidiEvent(metadata.getMessage());
+            else
+            {
+                for (int i = 0; i < numSamples; i++)
+                {
+                    const float sample = src[i * stride];
+                    left[i]  += sample * leftGain;
+                    right[i] += sample * rightGain;
+                }
+            }
+            
+            return;
         }
-
-        if (prevSample < endSample)
+        
+        for (int ch = 0; ch < numChannels; ch++)
         {
-            for (auto voice : voices)
+            auto* out = outputBuffer.getWritePointer(ch) + startSample;
+            const float channelGain = numChannels == 1 ? 1.f : panGains[(size_t) (ch % 2)];
+            
+            if (gain != nullptr)
+            {
+                for (int i = 0; i < numSamples; i++)
+                    out[i] += src[i * stride] * gain[i] * channelGain;
+            }
+            else
             {
-                if (voice->isPlaying())
-                    voice->process(buffer, prevSample, endSample - prevSample);
+                for (int i = 0; i < numSamples; i++)
+                    out[i] += src[i * stride] * channelGain;
             }
         }
     }
     
+    void applyFadeOut(int startSample, int numSamples)
+    {
+        const int numChannels = outputBuffer.getNumChannels();
+        
+        for (int i = startSample; i < startSample + numSamples; i++)
+        {
+            for (int ch = 0; ch < numChannels; ch++)
+                outputBuffer.getWritePointer(ch)[i] *= fadeOutGain;
+            
+            fadeOutGain = juce::jmax(0.f, fadeOutGain - fadeOutStep);
+        }
+        
+        if (fadeOutGain <= 0.f)
+            m_isPlaying = false;
+    }
+    
+    //returns true if the voice envelope is finished
+    bool checkVoiceEnvelope()
+    {
+        return !voiceEnvelope.isActive();
+    }
+    
+    //==============================================================================
+    juce::AudioBuffer<float> outputBuffer;
+    
+    Modules moduleList;
+    ModSources modulationSourceList;
+    EnvelopeModule voiceEnvelope;
+    bool m_isPlaying=false;
+    bool m_isReleasing = false;
+    juce::MidiMessage noteOnMessage;
+    
+    float fadeOutGain = 1.f;
+    float fadeOutStep = 0.f;
+    float lastPeakLevel = 0.f;
+    SilenceDetector silenceDetector;
+    float currentFreqHz = 0.f;
+    bool controlTickPending = true;
+    
+    //sources that restarted, or came off audio rate, and must be caught up with the control clock
+    std::array<bool, ModSources::size> sourceBehindClock {};
+    ModuleProfiler::Counter* modulationProfilerCounter = nullptr;
+    
+    //centred until told otherwise
+    float pan = 0.f;
+    float spreadOffset = 0.f;
+    std::array<float, 2> panGains { juce::MathConstants<float>::sqrt2 * 0.5f, juce::MathConstants<float>::sqrt2 * 0.5f };
+    
+    juce::ValueTree m_glideTimeParamData;
+    PortamentoController portaController;
+    ParameterQueue::Slot portaTimeSlot { [this] (float time) { portaController.setPortamentoTime(time); } };
+};
+
+/**
+ A fixed capacity stack of held notes, used for mono and legato note priority.
+ Unlike a std::list this never allocates, so it is safe to use on the audio thread
+ */
+class NoteHistory
+{
+public:
+    
+    static constexpr int capacity = 128;
+    
+    void add(const juce::MidiMessage& message)
+    {
+        //drop the oldest note once full
+        if (numNotes == capacity)
+            removeAt(0);
+        
+        notes[(size_t) numNotes++] = message;
+    }
+    
+    void removeNote(int noteNumber)
+    {
+        for (int i = numNotes; --i >= 0;)
+            if (notes[(size_t) i].getNoteNumber() == noteNumber)
+                removeAt(i);
+    }
+    
+    const juce::MidiMessage& getLast() const
+    {
+        jassert(numNotes > 0);
+        return notes[(size_t) numNotes - 1];
+    }
+    
+    int size() const
+    {
+        return numNotes;
+    }
+    
+private:
+    
+    void removeAt(int index)
+    {
+        for (int i = index; i < numNotes - 1; i++)
+            notes[(size_t) i] = notes[(size_t) i + 1];
+        
+        numNotes--;
+    }
+    
+    std::array<juce::MidiMessage, capacity> notes;
+    int numNotes = 0;
+};
+
+/**
+ Book keeping for which voices are in use. Voices are referred to by index, the
+ active list is kept in index order so that voices are always mixed in the same
+ order, and held notes are mapped straight to the voice playing them
+ */
+template<int NumVoices>
+class VoiceTable
+{
+public:
+    
+    VoiceTable()
+    {
+        clear();
+    }
+    
+    void clear()
+    {
+        numActive = 0;
+        numFree = NumVoices;
+        
+        //lowest index on top of the stack
+        for (int i = 0; i < NumVoices; i++)
+        {
+            freeVoices[(size_t) i] = NumVoices - 1 - i;
+            heldNote[(size_t) i] = -1;
+            isActive[(size_t) i] = false;
+        }
+        
+        noteToVoice.fill(-1);
+        numHeldPerNote.fill(0);
+    }
+    
+    /** returns the index of an idle voice and marks it active, or -1 if every voice is in use */
+    int takeFreeVoice()
+    {
+        if (numFree == 0)
+            return -1;
+        
+        const int voice = freeVoices[(size_t) --numFree];
+        markActive(voice);
+        return voice;
+    }
+    
+    /** called when a voice starts, or glides to, a note that is held down */
+    void voiceHeld(int voice, int noteNumber)
+    {
+        voiceReleased(voice);
+        markActive(voice);
+        
+        if (!juce::isPositiveAndBelow(noteNumber, numNotes))
+            return;
+        
+        heldNote[(size_t) voice] = noteNumber;
+        numHeldPerNote[(size_t) noteNumber]++;
+        
+        //the first voice to take a note keeps it, as with a search from voice 0
+        if (noteToVoice[(size_t) noteNumber] < 0 || noteToVoice[(size_t) noteNumber] > voice)
+            noteToVoice[(size_t) noteNumber] = voice;
+    }
+    
+    /** called when a voice is released or reset */
+    void voiceReleased(int voice)
+    {
+        const int noteNumber = heldNote[(size_t) voice];
+        
+        if (noteNumber < 0)
+            return;
+        
+        heldNote[(size_t) voice] = -1;
+        
+        if (--numHeldPerNote[(size_t) noteNumber] == 0)
+            noteToVoice[(size_t) noteNumber] = -1;
+        else if (noteToVoice[(size_t) noteNumber] == voice)
+            noteToVoice[(size_t) noteNumber] = findHeldVoice(noteNumber);
+    }
+    
+    /** returns the voice holding a note, or -1 */
+    int getVoiceForNote(int noteNumber) const
+    {
+        if (!juce::isPositiveAndBelow(noteNumber, numNotes))
+            return -1;
+        
+        return noteToVoice[(size_t) noteNumber];
+    }
+    
+    int getNumActive() const
+    {
+        return numActive;
+    }
+    
+    int getActive(int index) const
+    {
+        return activeVoices[(size_t) index];
+    }
+    
+    /** moves any active voices for which isFinished returns true back to the free list */
+    template <typename Fn>
+    void removeFinished(Fn&& isFinished)
+    {
+        int numKept = 0;
+        
+        for (int i = 0; i < numActive; i++)
+        {
+            const int voice = activeVoices[(size_t) i];
+            
+            if (isFinished(voice))
+            {
+                voiceReleased(voice);
+                isActive[(size_t) voice] = false;
+                freeVoices[(size_t) numFree++] = voice;
+            }
+            else
+            {
+                activeVoices[(size_t) numKept++] = voice;
+            }
+        }
+        
+        numActive = numKept;
+    }
+    
+private:
+    
+    void markActive(int voice)
+    {
+        if (isActive[(size_t) voice])
+            return;
+        
+        isActive[(size_t) voice] = true;
+        
+        //insert in index order
+        int i = numActive++;
+        
+        for (; i > 0 && activeVoices[(size_t) i - 1] > voice; i--)
+            activeVoices[(size_t) i] = activeVoices[(size_t) i - 1];
+        
+        activeVoices[(size_t) i] = voice;
+    }
+    
+    //only needed when the same note is held by more than one voice
+    int findHeldVoice(int noteNumber) const
+    {
+        for (int i = 0; i < numActive; i++)
+            if (heldNote[(size_t) activeVoices[(size_t) i]] == noteNumber)
+                return activeVoices[(size_t) i];
+        
+        return -1;
+    }
+    
+    static constexpr int numNotes = 128;
+    
+    std::array<int, NumVoices> activeVoices;
+    std::array<int, NumVoices> freeVoices;
+    std::array<int, NumVoices> heldNote;
+    std::array<bool, NumVoices> isActive;
+    int numActive = 0;
+    int numFree = 0;
+    
+    std::array<int, numNotes> noteToVoice;
+    std::array<int, numNotes> numHeldPerNote;
+};
+
+template<typename Modules, typename ModSources, int NumVoices = 32>
+class VoiceController : public juce::ValueTree::Listener,
+                        private VoiceThreadPool::Job
+{
+    static_assert(NumVoices > 0, "A voice controller needs at least one voice");
+    
+    using VoiceType = Voice<Modules, ModSources>;
+    
+    //a few voices over the polyphony are kept spare, so that a stolen
+    //voice can fade out while the new note starts in one of these
+    static constexpr int numFadeOutVoices = std::min(8, std::max(1, NumVoices / 4));
+    static constexpr int numVoices = NumVoices + numFadeOutVoices;
+    
+    //voices are stored contiguously and referred to by index
+    std::unique_ptr<VoiceType[]> voices;
+    VoiceTable<numVoices> voiceTable;
+    VoiceType* latestVoice = nullptr;
+    
+    public:
+    
+    enum class StealPolicy
+    {
+        oldest=0, quietest, releasedFirst, sameNote
+    };
+    
+    private:
+    
+    //voice stealing
+    std::atomic<StealPolicy> stealPolicy { StealPolicy::oldest };
+    std::atomic<int> polyphonyLimit { NumVoices };
+    std::array<juce::uint64, (size_t) numVoices> voiceStartOrder {};
+    juce::uint64 numNotesStarted = 0;
+    static constexpr float stealFadeOutSeconds = 0.005f;
+    
+    //cpu budget, the effective polyphony is lowered while rendering the voices
+    //takes more than this proportion of the time available for the block
+    std::atomic<float> cpuBudget { 0.f };
+    float cpuLoad = 0.f;
+    int cpuPolyphonyLimit = NumVoices;
+    double currentSampleRate = 44100.0;
+    
+    //modulation sources are evaluated once every controlRate samples
+    std::atomic<int> controlRate { 32 };
+    ControlClock controlClock;
+    
+    //stereo placement, each voice sits at pan plus its share of the spread
+    std::atomic<float> voicePan { 0.f };
+    std::atomic<float> stereoSpread { 0.f };
+    
+    //splits each block at its note events
+    MidiScheduler midiScheduler;
+    
+    //a voice stops once its envelope is done and it has been quiet for the hold time
+    std::atomic<float> silenceThreshold { juce::Decibels::decibelsToGain(-60.f) };
+    std::atomic<float> silenceHoldSeconds { 0.005f };
+    
+    //multi threaded rendering
+    int numRenderThreads = 1;
+    std::unique_ptr<VoiceThreadPool> renderPool;
+    std::vector<VoiceScratch> scratchBuffers;
+    int preparedBlockSize = 0;
+    int renderStartSample = 0;
+    int renderNumSamples = 0;
+    
+    //below these sizes the cost of waking a worker outweighs the work handed to it
+    static constexpr int minVoicesPerThread = 2;
+    static constexpr int minSamplesPerThreadedBlock = 16;
+    
+    static constexpr int maxControlRate = 1024;
+    
+    enum class ArticulationType
+    {
+        poly=0, mono, legato
+    };
+    
+    ArticulationType articulationType = ArticulationType::legato;
+    NoteHistory monoNoteHistory;
+    juce::ValueTree m_voiceModeData;
+    juce::ValueTree m_voiceStealData;
+    juce::ValueTree m_polyphonyData;
+    juce::ValueTree m_cpuBudgetData;
+    juce::ValueTree m_controlRateData;
+    juce::ValueTree m_panData;
+    juce::ValueTree m_stereoSpreadData;
+    juce::ValueTree m_midiSplitSizeData;
+    
+    ParameterQueue::Slot voiceModeSlot   { [this] (float v) { setArticulationType(ArticulationType(juce::roundToInt(v))); } };
+    ParameterQueue::Slot voiceStealSlot  { [this] (float v) { setStealPolicy(StealPolicy(juce::roundToInt(v))); } };
+    ParameterQueue::Slot polyphonySlot   { [this] (float v) { setPolyphonyLimit(juce::roundToInt(v)); } };
+    ParameterQueue::Slot cpuBudgetSlot   { [this] (float v) { setCpuBudget(v); } };
+    ParameterQueue::Slot controlRateSlot { [this] (float v) { setControlRate(juce::roundToInt(v)); } };
+    ParameterQueue::Slot panSlot         { [this] (float v) { setPan(v); } };
+    ParameterQueue::Slot stereoSpreadSlot { [this] (float v) { setStereoSpread(v); } };
+    ParameterQueue::Slot midiSplitSizeSlot { [this] (float v) { setMinimumSubBlockSize(juce::roundToInt(v)); } };
+    
+public:
+    
+    VoiceController()
+    : voices(std::make_unique<VoiceType[]>((size_t) numVoices))
+    {
+    }
+    
+    virtual ~VoiceController() {}
+    
+    /** numChannels is the size of the bus that the voices are mixed onto */
+    virtual void prepare(float sampleRate, int bufferSize, int numChannels = 2)
+    {
+        currentSampleRate = sampleRate;
+        preparedBlockSize = bufferSize;
+        
+        for (int i = 0; i < numVoices; i++)
+        {
+            voices[i].prepare(sampleRate, bufferSize, numChannels);
+        }
+        
+        //the pool is (re)built here as prepare is never called alongside process
+        const int numWorkerThreads = numRenderThreads - 1;
+        
+        if (numWorkerThreads <= 0)
+            renderPool.reset();
+        else if (renderPool == nullptr || renderPool->getNumWorkers() != numRenderThreads)
+            renderPool = std::make_unique<VoiceThreadPool>(numWorkerThreads);
+        
+        scratchBuffers.resize((size_t) juce::jmax(1, numRenderThreads));
+        
+        for (auto& scratch : scratchBuffers)
+            scratch.prepare(bufferSize);
+    }
+    
+    /**
+     Sets how many threads, including the audio thread, may be used to render
+     voices. 1 renders every voice on the audio thread. Takes effect on the next
+     call to prepare. The output is identical whatever the number of threads
+     */
+    void setNumRenderThreads(int numThreads)
+    {
+        numRenderThreads = juce::jmax(1, numThreads);
+    }
+    
+    int getNumRenderThreads() const
+    {
+        return numRenderThreads;
+    }
+    
+    virtual void reset()
+    {
+        for (int i = 0; i < numVoices; i++)
+        {
+            voices[i].reset();
+        }
+        
+        voiceTable.clear();
+        latestVoice = nullptr;
+        cpuLoad = 0.f;
+        cpuPolyphonyLimit = NumVoices;
+        controlClock.samplesUntilTick = 0;
+    }
+    
+    virtual void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int numSamples)
+    {
+        const auto renderStartTicks = juce::Time::getHighResolutionTicks();
+        
+        midiScheduler.process(midiMessages, startSample, numSamples,
+                              [this] (const juce::MidiMessage& message) { handleMidiEvent(message); },
+                              [this, &buffer] (int subBlockStart, int subBlockSize) { renderVoices(buffer, subBlockStart, subBlockSize); });
+        
+        updateCpuBudget(juce::Time::getHighResolutionTicks() - renderStartTicks, numSamples);
+    }
+    
     void setArticulationType(ArticulationType type)
     {
         reset();
         articulationType = type;
     }
     
+    void setStealPolicy(StealPolicy newPolicy)
+    {
+        stealPolicy = newPolicy;
+    }
+    
+    /** sets the maximum number of voices that may sound at once, up to the Polyphony template argument */
+    void setPolyphonyLimit(int newLimit)
+    {
+        polyphonyLimit = juce::jlimit(1, NumVoices, newLimit);
+    }
+    
+    /**
+     Sets the proportion of each block's real time that voice rendering may use
+     before voices are shed, 0 turns the budget off
+     */
+    void setCpuBudget(float proportionOfBlock)
+    {
+        cpuBudget = juce::jlimit(0.f, 1.f, proportionOfBlock);
+    }
+    
+    /**
+     Sets how many samples apart the modulation sources are evaluated. Modulated
+     parameters are interpolated between these points
+     */
+    void setControlRate(int samplesPerTick)
+    {
+        controlRate = juce::jlimit(1, maxControlRate, samplesPerTick);
+    }
+    
+    int getControlRate() const
+    {
+        return controlRate;
+    }
+    
+    /**
+     The shortest stretch that a note event may split a block into. Notes
+     closer together than this start early, at the start of the stretch.
+     Controllers and other midi never split the block, see MidiScheduler
+     */
+    void setMinimumSubBlockSize(int numSamples)
+    {
+        midiScheduler.setMinimumSubBlockSize(numSamples);
+    }
+    
+    int getMinimumSubBlockSize() const
+    {
+        return midiScheduler.getMinimumSubBlockSize();
+    }
+    
+    /**
+     The rms level below which a voice that has finished its envelope is
+     counted as silent and stopped, -60dB by default
+     */
+    void setSilenceThreshold(float decibels)
+    {
+        silenceThreshold = juce::Decibels::decibelsToGain(decibels);
+    }
+    
+    /** how long a voice must stay below the silence threshold before it is stopped */
+    void setSilenceHoldTime(float seconds)
+    {
+        silenceHoldSeconds = juce::jmax(0.f, seconds);
+    }
+    
+    /** the position of every voice in the stereo field, from -1 (left) to 1 (right) */
+    void setPan(float newPan)
+    {
+        voicePan = juce::jlimit(-1.f, 1.f, newPan);
+    }
+    
+    /**
+     Spreads voices across the stereo field around the pan position, from 0
+     (all voices at the pan position) to 1. Each new note takes the next place
+     in the spread, alternating between left and right
+     */
+    void setStereoSpread(float spread)
+    {
+        stereoSpread = juce::jlimit(0.f, 1.f, spread);
+    }
+    
+    /** the polyphony currently allowed, after the cpu budget has been applied */
+    int getEffectivePolyphony() const
+    {
+        return juce::jmin(polyphonyLimit.load(), cpuPolyphonyLimit);
+    }
+    
     VoiceType* getVoice(int index)
     {
-        if (index < 0 || index > numVoices)
+        if (index < 0 || index >= numVoices)
             return nullptr;
         
-        return voices[index].get();
+        return &voices[index];
     }
     
     VoiceType* getLatestVoice()
     {
-        return latestVoice.get();
+        return latestVoice;
     }
     
-    const int getNumVoices()
+    static constexpr int getNumVoices()
     {
         return numVoices;
     }
     
+    /** the number of voices that are currently sounding */
+    int getNumActiveVoices() const
+    {
+        return voiceTable.getNumActive();
+    }
+    
     //sets data void the voice controller to use
     //in order to track certain parameters
     void setData(juce::ValueTree valueTree)
     {
-        m_voiceModeData = valueTree.getChildWithName(Module::ParamIdents::MODULES)
-                                   .getChildWithProperty(Module::ParamIdents::NAME, "Voice Control")
-                                   .getChildWithName(Module::ParamIdents::PARAMETERS)
-                                   .getChildWithProperty(Module::ParamIdents::PARAMETER_NAME, "Voice Mode");
-        m_voiceModeData.addListener(this);
-        jassert(m_voiceModeData.isValid());
-        valueTreePropertyChanged(m_voiceModeData, Module::ParamIdents::VALUE);
+        auto listenTo = [&] (juce::ValueTree& paramData, juce::String paramName)
+        {
+            paramData = valueTree.getChildWithName(Module::ParamIdents::MODULES)
+                                 .getChildWithProperty(Module::ParamIdents::NAME, "Voice Control")
+                                 .getChildWithName(Module::ParamIdents::PARAMETERS)
+                                 .getChildWithProperty(Module::ParamIdents::PARAMETER_NAME, paramName);
+            paramData.addListener(this);
+            jassert(paramData.isValid());
+            valueTreePropertyChanged(paramData, Module::ParamIdents::VALUE);
+        };
+        
+        listenTo(m_voiceModeData,  "Voice Mode");
+        listenTo(m_voiceStealData, "Voice Steal");
+        listenTo(m_polyphonyData,  "Polyphony");
+        listenTo(m_cpuBudgetData,  "CPU Budget");
+        listenTo(m_controlRateData, "Control Rate");
+        listenTo(m_panData, "Pan");
+        listenTo(m_stereoSpreadData, "Stereo Spread");
+        listenTo(m_midiSplitSizeData, "MIDI Split Size");
+    }
+    
+    /**
+     Routes changes from the value tree through the queue, for the controller
+     and every voice, so that they are applied at the start of a block rather
+     than part way through one
+     */
+    void setParameterQueue(ParameterQueue* queue)
+    {
+        for (auto* slot : { &voiceModeSlot, &voiceStealSlot, &polyphonySlot, &cpuBudgetSlot, &controlRateSlot,
+                            &panSlot, &stereoSpreadSlot, &midiSplitSizeSlot })
+            slot->setQueue(queue);
+        
+        for (int i = 0; i < numVoices; i++)
+            voices[i].setParameterQueue(queue);
+    }
+    
+    /** see Voice::setProfiler */
+    void setProfiler(ModuleProfiler& profiler)
+    {
+        for (int i = 0; i < numVoices; i++)
+            voices[i].setProfiler(profiler);
     }
     
 private:
     
+    void renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        //the voices render at the same offset as the host buffer while that fits in
+        //what they were prepared for, a larger block is rendered in pieces from their start
+        if (startSample + numSamples <= preparedBlockSize)
+        {
+            renderVoicePiece(buffer, startSample, startSample, numSamples);
+            return;
+        }
+        
+        for (int done = 0; done < numSamples;)
+        {
+            const int pieceSize = juce::jmin(preparedBlockSize, numSamples - done);
+            renderVoicePiece(buffer, startSample + done, 0, pieceSize);
+            done += pieceSize;
+        }
+    }
+    
+    /** renders the voices from startSample in their own buffers, and adds them to the host buffer from bufferStartSample */
+    void renderVoicePiece(juce::AudioBuffer<float>& buffer, int bufferStartSample, int startSample, int numSamples)
+    {
+        jassert(startSample + numSamples <= preparedBlockSize);
+        
+        const int numActive = voiceTable.getNumActive();
+        
+        renderStartSample = startSample;
+        renderNumSamples  = numSamples;
+        
+        //a new rate takes over from the tick that is already due
+        if (controlClock.samplesPerTick != controlRate)
+        {
+            controlClock.samplesPerTick = controlRate;
+            controlClock.samplesUntilTick = juce::jmin(controlClock.samplesUntilTick, controlClock.samplesPerTick);
+        }
+        
+        const float pan = voicePan;
+        const float spread = stereoSpread;
+        const float threshold = silenceThreshold;
+        const int holdSamples = juce::roundToInt(currentSampleRate * silenceHoldSeconds);
+        
+        for (int i = 0; i < numActive; i++)
+        {
+            auto& voice = voices[voiceTable.getActive(i)];
+            voice.setPan(juce::jlimit(-1.f, 1.f, pan + spread * voice.getSpreadOffset()));
+            voice.setSilenceDetection(threshold, holdSamples);
+        }
+        
+        //voices are rendered in groups that fill the SIMD lanes, the groups
+        //only depend on the active list so the threading does not change them
+        const int numGroups = (numActive + VoiceLanes::numLanes - 1) / VoiceLanes::numLanes;
+        const int numThreads = getNumThreadsToUse(numActive, numSamples);
+        
+        if (numThreads > 1)
+        {
+            renderPool->run(*this, numGroups, numThreads);
+        }
+        else
+        {
+            for (int i = 0; i < numGroups; i++)
+                runJob(i, 0);
+        }
+        
+        //always summed in voice order so the result does not depend on which thread finished first
+        for (int i = 0; i < numActive; i++)
+        {
+            const auto& voiceBus = voices[voiceTable.getActive(i)].getOutputBuffer();
+            
+            for (int ch = 0; ch < juce::jmin(buffer.getNumChannels(), voiceBus.getNumChannels()); ch++)
+                juce::FloatVectorOperations::add(buffer.getWritePointer(ch) + bufferStartSample,
+                                                 voiceBus.getReadPointer(ch) + startSample, numSamples);
+        }
+        
+        voiceTable.removeFinished([this] (int voice)
+        {
+            return !voices[voice].isPlaying();
+        });
+        
+        controlClock.advance(numSamples);
+    }
+    
+    int getNumThreadsToUse(int numActiveVoices, int numSamples) const
+    {
+        if (renderPool == nullptr || numSamples < minSamplesPerThreadedBlock)
+            return 1;
+        
+        return juce::jlimit(1, renderPool->getNumWorkers(), numActiveVoices / minVoicesPerThread);
+    }
+    
+    void runJob(int jobIndex, int workerIndex) override
+    {
+        std::array<VoiceType*, (size_t) VoiceLanes::numLanes> group;
+        
+        const int first = jobIndex * VoiceLanes::numLanes;
+        const int numInGroup = juce::jmin(VoiceLanes::numLanes, voiceTable.getNumActive() - first);
+        
+        for (int g = 0; g < numInGroup; g++)
+            group[(size_t) g] = &voices[voiceTable.getActive(first + g)];
+        
+        VoiceType::processGroup(group.data(), numInGroup, scratchBuffers[(size_t) workerIndex], renderStartSample, renderNumSamples,
+                                controlClock);
+    }
+    
     void valueTreePropertyChanged(juce::ValueTree &tree, const juce::Identifier &property)
     {
-        if (property == Module::ParamIdents::VALUE)
+        if (property != Module::ParamIdents::VALUE)
+            return;
+        
+        //called on the message thread, the values are handed to the audio thread through the slots
+        auto value = tree[Module::ParamIdents::VALUE].toString();
+        
+        if (tree == m_voiceModeData)
+        {
+            if (value == "Poly") voiceModeSlot.post(float(ArticulationType::poly));
+            else if (value == "Mono") voiceModeSlot.post(float(ArticulationType::mono));
+            else if (value == "Legato") voiceModeSlot.post(float(ArticulationType::legato));
+        }
+        else if (tree == m_voiceStealData)
+        {
+            if (value == "Oldest") voiceStealSlot.post(float(StealPolicy::oldest));
+            else if (value == "Quietest") voiceStealSlot.post(float(StealPolicy::quietest));
+            else if (value == "Released First") voiceStealSlot.post(float(StealPolicy::releasedFirst));
+            else if (value == "Same Note") voiceStealSlot.post(float(StealPolicy::sameNote));
+        }
+        else if (tree == m_polyphonyData)
+        {
+            polyphonySlot.post(float(value.getIntValue()));
+        }
+        else if (tree == m_cpuBudgetData)
+        {
+            cpuBudgetSlot.post(value.getFloatValue());
+        }
+        else if (tree == m_controlRateData)
+        {
+            controlRateSlot.post(float(value.getIntValue()));
+        }
+        else if (tree == m_panData)
         {
-            auto value = tree[Module::ParamIdents::VALUE].toString();
+            panSlot.post(value.getFloatValue());
+        }
+        else if (tree == m_stereoSpreadData)
+        {
+            stereoSpreadSlot.post(value.getFloatValue());
+        }
+        else if (tree == m_midiSplitSizeData)
+        {
+            midiSplitSizeSlot.post(float(value.getIntValue()));
+        }
+    }
+    
+    //==============================================================================
+    void updateCpuBudget(juce::int64 elapsedTicks, int numSamples)
+    {
+        const float budget = cpuBudget;
+        const int numSounding = getNumSoundingVoices();
+        
+        if (budget <= 0.f || numSamples <= 0)
+        {
+            cpuPolyphonyLimit = NumVoices;
+        }
+        else
+        {
+            const double blockSeconds = double(numSamples) / currentSampleRate;
+            const float load = float(juce::Time::highResolutionTicksToSeconds(elapsedTicks) / blockSeconds);
+            
+            //smoothed so that a single slow block does not cut voices
+            cpuLoad += (load - cpuLoad) * 0.2f;
             
-            if (value == "Poly") setArticulationType(ArticulationType::poly);
-            else if (value == "Mono") setArticulationType(ArticulationType::mono);
-            else if (value == "Legato") setArticulationType(ArticulationType::legato);
+            if (cpuLoad > budget)
+            {
+                cpuPolyphonyLimit = juce::jmax(1, juce::jmin(cpuPolyphonyLimit, numSounding) - 1);
+            }
+            else if (cpuLoad < budget * 0.75f && numSounding >= cpuPolyphonyLimit)
+            {
+                //only hand voices back while they are being asked for
+                cpuPolyphonyLimit = juce::jmin(NumVoices, cpuPolyphonyLimit + 1);
+            }
+        }
+        
+        //fade out anything over the limit, including after the polyphony parameter is lowered
+        for (int i = numSounding; i > getEffectivePolyphony(); i--)
+        {
+            if (auto* victim = chooseVoiceToSteal(-1))
+                stealVoice(victim);
         }
     }
+    
+    int getNumSoundingVoices() const
+    {
+        int numSounding = 0;
+        
+        for (int i = 0; i < voiceTable.getNumActive(); i++)
+            if (!voices[voiceTable.getActive(i)].isFadingOut())
+                numSounding++;
+        
+        return numSounding;
+    }
+    
+    int getStealFadeOutSamples() const
+    {
+        return juce::roundToInt(currentSampleRate * stealFadeOutSeconds);
+    }
+    
+    /**
+     Picks a sounding voice to make way for a new note according to the steal
+     policy, noteNumber is the note about to start or -1
+     */
+    VoiceType* chooseVoiceToSteal(int noteNumber)
+    {
+        const auto policy = stealPolicy.load();
+        VoiceType* best = nullptr;
+        
+        auto isBetter = [&] (int voice)
+        {
+            auto& candidate = voices[voice];
+            auto& current = *best;
+            
+            switch (policy)
+            {
+                case StealPolicy::quietest:
+                    return candidate.getLevel() < current.getLevel();
+                    
+                case StealPolicy::sameNote:
+                {
+                    const bool candidateMatches = noteNumber >= 0 && candidate.getNoteNumber() == noteNumber;
+                    const bool currentMatches   = noteNumber >= 0 && current.getNoteNumber() == noteNumber;
+                    
+                    if (candidateMatches != currentMatches)
+                        return candidateMatches;
+                    
+                    //otherwise fall back to released first
+                    [[fallthrough]];
+                }
+                case StealPolicy::releasedFirst:
+                {
+                    if (candidate.isReleasing() != current.isReleasing())
+                        return candidate.isReleasing();
+                    
+                    [[fallthrough]];
+                }
+                case StealPolicy::oldest:
+                default:
+                    return voiceStartOrder[(size_t) voice] < voiceStartOrder[(size_t) getIndexOf(best)];
+            }
+        };
+        
+        for (int i = 0; i < voiceTable.getNumActive(); i++)
+        {
+            const int voice = voiceTable.getActive(i);
+            
+            if (voices[voice].isFadingOut())
+                continue;
+            
+            if (best == nullptr || isBetter(voice))
+                best = &voices[voice];
+        }
+        
+        return best;
+    }
+    
+    /**
+     Used when every voice, including those fading out, is busy. The voice
+     nearest to silence is cut dead
+     */
+    VoiceType* chooseVoiceToCut()
+    {
+        VoiceType* best = nullptr;
+        
+        for (int i = 0; i < voiceTable.getNumActive(); i++)
+        {
+            auto& voice = voices[voiceTable.getActive(i)];
+            
+            if (best == nullptr || voice.getFadeOutGain() * voice.getLevel() < best->getFadeOutGain() * best->getLevel())
+                best = &voice;
+        }
+        
+        return best != nullptr ? best : &voices[0];
+    }
 
-    void handleMidiEvent(juce::MidiMessage message)
+    void handleMidiEvent(const juce::MidiMessage& message)
     {
         if (message.isNoteOn())
             doNoteOn(message);
         else if (message.isNoteOff())
             doNoteOff(message);
         else
-            for (auto v : voices)
-                v->applyMidi(message);
+            for (int i = 0; i < numVoices; i++)
+                voices[i].applyMidi(message);
     }
     
     void doNoteOn(juce::MidiMessage message)
     {
         
-        auto glideFromNote = monoNoteHistory.size() > 0 ? monoNoteHistory.back() : juce::MidiMessage();
-        monoNoteHistory.push_back(message);
+        auto glideFromNote = monoNoteHistory.size() > 0 ? monoNoteHistory.getLast() : juce::MidiMessage();
+        monoNoteHistory.add(message);
         
         switch (articulationType)
         {
             case ArticulationType::poly:
             {
                 NoteOnEvent noteOn = { message, false, glideFromNote};
-                auto nextVoice = getNextVoice();
+                auto nextVoice = getNextVoice(message.getNoteNumber());
                 nextVoice->reset();
-                nextVoice->noteOn(noteOn);
+                startVoice(nextVoice, noteOn);
                 break;
             }
             case ArticulationType::mono:
@@ -575,29 +1791,29 @@ private:
                 
                 if (latestVoice && latestVoice->isPlaying())
                 {
-                    latestVoice->noteOff(true);
+                    releaseVoice(latestVoice, true);
                 }
                 
                 //replace the mono voice with next voice and give note on
-                latestVoice = getNextVoice();
+                latestVoice = getNextVoice(message.getNoteNumber());
                 latestVoice->reset();
-                latestVoice->noteOn(noteOn);
+                startVoice(latestVoice, noteOn);
                 
                 break;
             }
             case ArticulationType::legato:
             {
                 //if is playing then initiate glide
-                if (latestVoice && latestVoice->isPlaying() && !latestVoice->isReleasing())
+                if (latestVoice && latestVoice->isPlaying() && !latestVoice->isReleasing() && !latestVoice->isFadingOut())
                 {
-                    latestVoice->noteOn({ message, true, glideFromNote});
+                    startVoice(latestVoice, { message, true, glideFromNote});
                 }
                 else
                 {
                     //else spin up a new note
-                    latestVoice = getNextVoice();
+                    latestVoice = getNextVoice(message.getNoteNumber());
                     latestVoice->reset();
-                    latestVoice->noteOn({ message, false, glideFromNote});
+                    startVoice(latestVoice, { message, false, glideFromNote});
                 }
                 break;
             }
@@ -608,10 +1824,7 @@ private:
     
     void doNoteOff(juce::MidiMessage message)
     {
-        monoNoteHistory.remove_if([message] (juce::MidiMessage& note) -> bool
-        {
-            return message.getNoteNumber() == note.getNoteNumber();
-        });
+        monoNoteHistory.removeNote(message.getNoteNumber());
         
         switch (articulationType)
         {
@@ -622,21 +1835,21 @@ private:
                 
                 if (v)
                 {
-                    v->noteOff( false);
+                    releaseVoice(v, false);
                 }
             }
             case ArticulationType::mono:
             {
                 if (latestVoice && message.getNoteNumber() == latestVoice->getNoteNumber())
                 {
-                    latestVoice->noteOff(false);
+                    releaseVoice(latestVoice, false);
                     
                     //if there is another key down then this is given a note on
                     if (monoNoteHistory.size() > 0)
                     {
-                        NoteOnEvent nod = { monoNoteHistory.back(), false, latestVoice->getCurrNoteOnMessage()};
-                        latestVoice = getNextVoice();
-                        latestVoice->noteOn( nod);
+                        NoteOnEvent nod = { monoNoteHistory.getLast(), false, latestVoice->getCurrNoteOnMessage()};
+                        latestVoice = getNextVoice(nod.midiMessage.getNoteNumber());
+                        startVoice(latestVoice, nod);
                     }
                 }
                 break;
@@ -648,12 +1861,12 @@ private:
                     //if there is another key down then this is given a note on
                     if (monoNoteHistory.size() > 0)
                     {
-                        NoteOnEvent nod = { monoNoteHistory.back(), true, latestVoice->getCurrNoteOnMessage()};
-                        latestVoice->noteOn( nod);
+                        NoteOnEvent nod = { monoNoteHistory.getLast(), true, latestVoice->getCurrNoteOnMessage()};
+                        startVoice(latestVoice, nod);
                     }
                     else
                     {
-                        latestVoice->noteOff(false);
+                        releaseVoice(latestVoice, false);
                     }
                 }
                 break;
@@ -663,36 +1876,70 @@ private:
         }
     }
     
-    std::shared_ptr<VoiceType> getNextVoice()
+    //all note ons and offs go through these so that the voice table stays in step
+    void startVoice(VoiceType* voice, const NoteOnEvent& event)
     {
-        for (auto v : voices)
+        if (!event.isLegatoNoteOn)
         {
-            if (!v->isPlaying())
-            {
-                return v;
-            }
+            voiceStartOrder[(size_t) getIndexOf(voice)] = ++numNotesStarted;
+            voice->setSpreadOffset(getSpreadOffset(numNotesStarted));
         }
         
-        if (voices[0]->isPlaying())
+        voice->noteOn(event);
+        voiceTable.voiceHeld(getIndexOf(voice), event.midiMessage.getNoteNumber());
+    }
+    
+    void releaseVoice(VoiceType* voice, bool isHardNoteOff)
+    {
+        voice->noteOff(isHardNoteOff);
+        voiceTable.voiceReleased(getIndexOf(voice));
+    }
+    
+    //the stolen voice gives up its note, so a later note off for it reaches whichever voice plays it next
+    void stealVoice(VoiceType* victim)
+    {
+        victim->startFadeOut(getStealFadeOutSamples());
+        voiceTable.voiceReleased(getIndexOf(victim));
+    }
+    
+    //successive notes alternate sides, moving between the middle and the edges
+    static float getSpreadOffset(juce::uint64 noteIndex)
+    {
+        static constexpr std::array<float, 8> offsets { -1.f, 1.f, -0.5f, 0.5f, -0.75f, 0.75f, -0.25f, 0.25f };
+        return offsets[(size_t) (noteIndex % offsets.size())];
+    }
+    
+    int getIndexOf(const VoiceType* voice) const
+    {
+        jassert(voice >= voices.get() && voice < voices.get() + numVoices);
+        return int(voice - voices.get());
+    }
+    
+    VoiceType* getNextVoice(int noteNumber)
+    {
+        //make room under the polyphony, the stolen voice fades out in the background
+        if (getNumSoundingVoices() >= getEffectivePolyphony())
         {
-            voices[0]->reset();
+            if (auto* victim = chooseVoiceToSteal(noteNumber))
+                stealVoice(victim);
         }
         
-        //TODO: steal a voice if no other is found
+        const int freeVoice = voiceTable.takeFreeVoice();
+        
+        if (freeVoice >= 0)
+            return &voices[freeVoice];
         
-        return voices[0];
+        //every spare voice is still fading, so one has to be cut short
+        auto* voice = chooseVoiceToCut();
+        voice->reset();
+        voiceTable.voiceReleased(getIndexOf(voice));
+        return voice;
     }
     
-    std::shared_ptr<VoiceType> getVoiceByNoteNumber(int noteNumber)
+    VoiceType* getVoiceByNoteNumber(int noteNumber)
     {
-        for (auto v : voices)
-        {
-            if (v->getNoteNumber() == noteNumber && v->isPlaying() && !v->isReleasing())
-            {
-                return v;
-            }
-        }
-        return nullptr;
+        const int voice = voiceTable.getVoiceForNote(noteNumber);
+        return voice >= 0 ? &voices[voice] : nullptr;
     }
 };
 
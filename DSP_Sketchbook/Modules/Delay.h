@@ -14,6 +14,22 @@ class Delay : public Module
 {
 public:
     
+    //the fastest delay rate, which sets the shortest delay time
+    static constexpr float maxRateHz = 10.f;
+    
+    static constexpr auto parameters = makeParameterSchema(
+        ParameterSpec::Float("Rate Hz", 1.5f, 0.5f, maxRateHz),
+        ParameterSpec::Float("Decay", 0.3f, 0.f, 1.f),
+        ParameterSpec::Float("Tone", 1.f, 0.f, 1.f),
+        ParameterSpec::Float("Wet", 1.f, 0.f, 1.f),
+        ParameterSpec::Float("Dry", 1.f, 0.f, 1.f));
+    
+    static constexpr int rateParam  = parameters.indexOf("Rate Hz");
+    static constexpr int decayParam = parameters.indexOf("Decay");
+    static constexpr int toneParam  = parameters.indexOf("Tone");
+    static constexpr int wetParam   = parameters.indexOf("Wet");
+    static constexpr int dryParam   = parameters.indexOf("Dry");
+    
     Delay()
     {
         
@@ -26,37 +42,9 @@ public:
             delayBufferR[i] = 0.f;
         }
         
-        setModuleParameters({
-            
-            Parameter::Float("Rate Hz", [&] (juce::var value)
-            {
-                setDelayTime(1 / float(value));
-                
-            }, 1.5f, 0.5f, 10.f),
-            
-            Parameter::Float("Decay", [&] (juce::var value)
-            {
-                setDecay(float(value));
-            }, 0.3f, 0.f, 1.f),
-            
-            Parameter::Float("Tone", [&] (juce::var value)
-            {
-                //TODO: this parameter
-                
-            }, 1.f, 0.f, 1.f),
-            
-            Parameter::Float("Wet", [&] (juce::var value)
-            {
-                wetGain = float(value);
-                
-            }, 1.f, 0.f, 1.f),
-            
-            Parameter::Float("Dry", [&] (juce::var value)
-            {
-                dryGain = float(value);
-                
-            }, 1.f, 0.f, 1.f),
-        });
+        //TODO: the tone parameter
+        setModuleParameters(parameters);
+        updateParameters();
     }
     
     ~Delay()
@@ -69,12 +57,31 @@ public:
     {
         return "Delay";
     }
+    
+    /** the echoes until they fall below -100dB, a decay of 1 repeats forever */
+    double getTailLengthSeconds() override
+    {
+        //read from the schema values, which are safe to read from any thread
+        const float tailDecay = getParameterValue(decayParam);
+        
+        if (tailDecay >= 1.f)
+            return std::numeric_limits<double>::infinity();
+        
+        const double numRepeats = tailDecay > 0.f ? std::ceil(std::log(1.0e-5) / std::log(double(tailDecay))) : 0.0;
+        
+        return (1.0 / double(getParameterValue(rateParam))) * (1.0 + numRepeats);
+    }
 
     //==============================================================================
     void prepareToPlay (float _samplerate, int _maxBufferSize) override
     {
         samplerate = _samplerate;
         wetBuffer.setSize(2, _maxBufferSize);
+        
+        //the tape runs fastest at the shortest delay time, size the resampling
+        //buffer for that case so that process never has to allocate
+        const float maxResampleRatio = (float(nativeSR) * maxRateHz) / samplerate;
+        resampledBuffer.setSize(2, int(std::ceil(float(_maxBufferSize) * maxResampleRatio)) + 1);
     }
 
     //==============================================================================
@@ -84,6 +91,8 @@ public:
         const int numChannels = 2;
         jassert(buffer.getNumChannels() == 2);
         
+        updateParameters();
+        
         for (int i = 0; i < 2; i++)
             wetBuffer.copyFrom(i, 0, buffer, i, 0, buffer.getNumSamples());
         
@@ -98,9 +107,9 @@ public:
         const float speedRatio = float(numSamples) / float(numSamplesToWrite);
         
         //single buffer
-        juce::AudioBuffer<float> rs(2, numSamplesToWrite);
-        float* inputResizedL = rs.getWritePointer(0);
-        float* inputResizedR = rs.getWritePointer(1);
+        jassert(numSamplesToWrite <= resampledBuffer.getNumSamples());
+        float* inputResizedL = resampledBuffer.getWritePointer(0);
+        float* inputResizedR = resampledBuffer.getWritePointer(1);
         
         //interpolate samples to there new length in the delay line
         readInterpL.process(speedRatio, signalL, inputResizedL, numSamplesToWrite, numSamples, 0);
@@ -176,6 +185,15 @@ private:
             read_ind = 0;
     }
     
+    /** reads the schema values, called at the start of each block */
+    void updateParameters()
+    {
+        setDelayTime(1.f / getParameterValue(rateParam));
+        setDecay(getParameterValue(decayParam));
+        wetGain = getParameterValue(wetParam);
+        dryGain = getParameterValue(dryParam);
+    }
+    
     void setDecay(float val)
     {
         decay = val;
@@ -202,6 +220,7 @@ private:
     float samplerate=44100;
     
     juce::AudioBuffer<float> wetBuffer;
+    juce::AudioBuffer<float> resampledBuffer;
     
     //native sample rate is a constant that
     //is used to interpolate input and output signal to
@@ -9,6 +9,7 @@
 */
 
 #include "EnvelopeModule.h"
+#include "../Engine/FastMath.h"
 
 EnvelopeModule::EnvelopeModule()
 {
@@ -23,34 +24,8 @@ EnvelopeModule::EnvelopeModule()
     setTargetRatioDR(0.0001);
     sends = 1.0f;
     
-    //addParameters
-    setModuleParameters({
-        
-        Parameter::Float("Attack", [this](juce::var value)
-        {
-            setAttackRate(value);
-        }, 0.01f, 0.001f, 10.0f),
-
-        Parameter::Float("Decay", [this](juce::var value)
-        {
-            setDecayRate(value);
-        }, 0.1f, 0.001f, 10.0f),
-
-        Parameter::Float("Sustain", [this](juce::var value)
-        {
-            setSustainLevel(value);
-        }, 0.8f, 0.0f, 1.0f),
-
-        Parameter::Float("Release", [this](juce::var value)
-        {
-            setReleaseRate(value);
-        }, 0.5f, 0.001f, 10.0f),
-        
-        Parameter::Float("Velocity", [this](juce::var value)
-        {
-            setVelocityMod(value);
-        }, 1.0f, 0.0f, 1.0f)
-    });
+    setModuleParameters(parameters);
+    updateParameters();
 }
 
 EnvelopeModule::~EnvelopeModule() {}
@@ -82,6 +57,8 @@ juce::String EnvelopeModule::getName()
 */
 void EnvelopeModule::process(juce::AudioBuffer<float>& inputBuffer)
 {
+    updateParameters();
+    
     for (int i = 0; i < inputBuffer.getNumSamples(); i++) {
         float temp = 1;
         processSample(&temp);
@@ -101,6 +78,8 @@ void EnvelopeModule::noteOn(const sketchbook::NoteOnEvent& event)
 {
     //set minimal attack and release values reletive to the length of a maximal waveform
     //setMinimalAttackRelease( Scale::naturalFreqFromMidiNumber(event.message.getNoteNumber()));
+    updateParameters();
+    
     if ((!event.isLegatoNoteOn) || state == env_release )
     {
         reset();
@@ -161,9 +140,33 @@ void EnvelopeModule::setVelocityMod(double velMod)
     velocityMod = velMod;
 }
 
+void EnvelopeModule::updateParameters()
+{
+    //the coefficients are only worked out again for the values that have changed
+    const float attack  = getParameterValue(attackParam);
+    const float decay   = getParameterValue(decayParam);
+    const float sustain = getParameterValue(sustainParam);
+    const float release = getParameterValue(releaseParam);
+    
+    if (attack != attackS)
+        setAttackRate(attack);
+    
+    if (decay != decayS)
+        setDecayRate(decay);
+    
+    if (double(sustain) != sustainLevel)
+        setSustainLevel(sustain);
+    
+    if (release != releaseS)
+        setReleaseRate(release);
+    
+    setVelocityMod(getParameterValue(velocityParam));
+}
+
 double EnvelopeModule::calcCoef(double rate, double targetRatio)
 {
-    return (rate <= 0) ? 0.0 : exp(-log((1.0 + targetRatio) / targetRatio) / rate);
+    //exp(-log(x) / rate), as 2^(-log2(x) / rate)
+    return (rate <= 0) ? 0.0 : sketchbook::FastMath::exp2(-sketchbook::FastMath::log2((1.0 + targetRatio) / targetRatio) / rate);
 }
 
 void EnvelopeModule::setSustainLevel(double level)
@@ -193,6 +196,168 @@ void EnvelopeModule::setTargetRatioDR(double targetRatio)
 }
 
 void EnvelopeModule::processSample(float* sample)
+{
+    float modulationValue = getNextValue();
+    *sample *= modulationValue;
+    internalBuffer.appendSingleSample(modulationValue);
+}
+
+void EnvelopeModule::processBlock(float* buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+    
+    updateParameters();
+    
+    float modulationValue = 0.f;
+    
+    for (int i = startSample; i < startSample + numSamples; i++)
+    {
+        modulationValue = getNextValue();
+        buffer[i] *= modulationValue;
+    }
+    
+    //only the latest value is read by the modulation mappings
+    internalBuffer.appendSingleSample(modulationValue);
+}
+
+void EnvelopeModule::processControl(int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+    
+    updateParameters();
+    
+    //idle, sustained and pedal held envelopes do not move, so one step is enough
+    const bool isStatic = state == env_idle || state == env_sustain || (state == env_release && sustainPedalOn);
+    const int numSteps = isStatic ? 1 : numSamples;
+    
+    float modulationValue = 0.f;
+    
+    for (int i = 0; i < numSteps; i++)
+        modulationValue = getNextValue();
+    
+    internalBuffer.appendSingleSample(modulationValue);
+}
+
+#if SKETCHBOOK_VOICE_LANES
+void EnvelopeModule::processLanes(EnvelopeModule* const* envs, int numEnvs, float* output, int numSamples)
+{
+    using sketchbook::VoiceLanes;
+    constexpr int numLanes = VoiceLanes::numLanes;
+    jassert(numEnvs <= numLanes);
+    
+    if (numSamples <= 0)
+        return;
+    
+    //the recursion runs in double as in getNextValue, so a register holds half
+    //as many envelopes as there are lanes and the lanes are run a group at a time
+    using Register = juce::dsp::SIMDRegister<double>;
+    using Mask = Register::vMaskType;
+    constexpr int groupSize = (int) Register::SIMDNumElements;
+    
+    auto select = [] (Mask mask, Register a, Register b)
+    {
+        return (a & mask) + (b & ~mask);
+    };
+    
+    auto setIf = [] (Mask& mask, int lane, bool condition)
+    {
+        mask.set((size_t) lane, condition ? ~uint64_t(0) : uint64_t(0));
+    };
+    
+    const auto zero = Register::expand(0.0);
+    const auto one  = Register::expand(1.0);
+    
+    for (int firstLane = 0; firstLane < numLanes; firstLane += groupSize)
+    {
+        const int numInGroup = juce::jlimit(0, groupSize, numEnvs - firstLane);
+        
+        auto value = zero, sends = zero, velocityGain = zero, sustainLevel = zero;
+        auto attackBase = zero, attackCoef = zero, decayBase = zero, decayCoef = zero;
+        auto releaseBase = zero, releaseCoef = zero, quickReleaseCoef = zero;
+        
+        //one mask per state, a lane is in at most one of them. Releases held by the
+        //sustain pedal are kept apart as they do not move
+        auto isAttack = Mask::expand(0), isDecay = Mask::expand(0), isSustain = Mask::expand(0);
+        auto isRelease = Mask::expand(0), isHeldRelease = Mask::expand(0), isQuickRelease = Mask::expand(0);
+        
+        for (int k = 0; k < numInGroup; k++)
+        {
+            auto& env = *envs[firstLane + k];
+            env.updateParameters();
+            
+            value.set((size_t) k, env.currValue);
+            sends.set((size_t) k, env.sends);
+            velocityGain.set((size_t) k, env.noteVelocity * env.velocityMod + (1 - env.velocityMod));
+            sustainLevel.set((size_t) k, env.sustainLevel);
+            attackBase.set((size_t) k, env.attackBase);
+            attackCoef.set((size_t) k, env.attackCoef);
+            decayBase.set((size_t) k, env.decayBase);
+            decayCoef.set((size_t) k, env.decayCoef);
+            releaseBase.set((size_t) k, env.releaseBase);
+            releaseCoef.set((size_t) k, env.releaseCoef);
+            quickReleaseCoef.set((size_t) k, env.quickReleaseCoef);
+            
+            setIf(isAttack,       k, env.state == env_attack);
+            setIf(isDecay,        k, env.state == env_decay);
+            setIf(isSustain,      k, env.state == env_sustain);
+            setIf(isRelease,      k, env.state == env_release && !env.sustainPedalOn);
+            setIf(isHeldRelease,  k, env.state == env_release && env.sustainPedalOn);
+            setIf(isQuickRelease, k, env.state == env_quick_release);
+        }
+        
+        for (int i = 0; i < numSamples; i++)
+        {
+            value = select(isAttack,       attackBase + value * attackCoef,        value);
+            value = select(isDecay,        decayBase + value * decayCoef,          value);
+            value = select(isRelease,      releaseBase + value * releaseCoef,      value);
+            value = select(isQuickRelease, releaseBase + value * quickReleaseCoef, value);
+            
+            //state changes, as in getNextValue
+            const auto attackDone  = isAttack & Register::greaterThanOrEqual(value, one);
+            const auto decayDone   = isDecay & Register::lessThanOrEqual(value, sustainLevel);
+            const auto releaseDone = (isRelease | isQuickRelease) & Register::lessThanOrEqual(value, zero);
+            
+            value = select(attackDone,  one,          value);
+            value = select(decayDone,   sustainLevel, value);
+            value = select(releaseDone, zero,         value);
+            
+            isAttack       = isAttack & ~attackDone;
+            isDecay        = (isDecay & ~decayDone) | attackDone;
+            isSustain      = isSustain | decayDone;
+            isRelease      = isRelease & ~releaseDone;
+            isQuickRelease = isQuickRelease & ~releaseDone;
+            
+            //in the same order as getNextValue
+            const auto out = value * sends * velocityGain;
+            float* dest = output + i * numLanes + firstLane;
+            
+            for (int k = 0; k < groupSize; k++)
+                dest[k] = float(out.get((size_t) k));
+        }
+        
+        //write the lanes back
+        for (int k = 0; k < numInGroup; k++)
+        {
+            auto& env = *envs[firstLane + k];
+            env.currValue = value.get((size_t) k);
+            
+            if (isAttack.get((size_t) k) != 0)                                             env.state = env_attack;
+            else if (isDecay.get((size_t) k) != 0)                                         env.state = env_decay;
+            else if (isSustain.get((size_t) k) != 0)                                       env.state = env_sustain;
+            else if (isRelease.get((size_t) k) != 0 || isHeldRelease.get((size_t) k) != 0) env.state = env_release;
+            else if (isQuickRelease.get((size_t) k) != 0)                                  env.state = env_quick_release;
+            else                                                                           env.state = env_idle;
+            
+            //only the latest value is read by the modulation mappings
+            env.internalBuffer.appendSingleSample(output[(numSamples - 1) * numLanes + firstLane + k]);
+        }
+    }
+}
+#endif
+
+inline float EnvelopeModule::getNextValue()
 {
     switch (state) {
             
@@ -242,9 +407,7 @@ void EnvelopeModule::processSample(float* sample)
             break;
     }
     
-    float modulationValue = currValue * sends * (noteVelocity * velocityMod + (1-velocityMod));
-    *sample *= modulationValue;
-    internalBuffer.appendSingleSample(modulationValue);
+    return float(currValue * sends * (noteVelocity * velocityMod + (1-velocityMod)));
 }
 
 void EnvelopeModule::setMinimalAttackRelease(float pitch)
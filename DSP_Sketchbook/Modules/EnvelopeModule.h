@@ -11,6 +11,7 @@
 #pragma once
 #include <JuceHeader.h>
 #include "../Engine/Module.h"
+#include "../Engine/VoiceLanes.h"
 
 //MARK: Envelope
 class EnvelopeModule : public sketchbook::Module
@@ -26,6 +27,19 @@ public:
         env_quick_release
     } state;
     
+    static constexpr auto parameters = sketchbook::makeParameterSchema(
+        sketchbook::ParameterSpec::Float("Attack", 0.01f, 0.001f, 10.0f),
+        sketchbook::ParameterSpec::Float("Decay", 0.1f, 0.001f, 10.0f),
+        sketchbook::ParameterSpec::Float("Sustain", 0.8f, 0.0f, 1.0f),
+        sketchbook::ParameterSpec::Float("Release", 0.5f, 0.001f, 10.0f),
+        sketchbook::ParameterSpec::Float("Velocity", 1.0f, 0.0f, 1.0f));
+    
+    static constexpr int attackParam   = parameters.indexOf("Attack");
+    static constexpr int decayParam    = parameters.indexOf("Decay");
+    static constexpr int sustainParam  = parameters.indexOf("Sustain");
+    static constexpr int releaseParam  = parameters.indexOf("Release");
+    static constexpr int velocityParam = parameters.indexOf("Velocity");
+    
     EnvelopeModule();
     
     ~EnvelopeModule();
@@ -40,6 +54,19 @@ public:
     
     void processSample(float* sample) override;
     
+    void processBlock(float* buffer, int startSample, int numSamples) override;
+    
+    void processControl(int numSamples) override;
+    
+   #if SKETCHBOOK_VOICE_LANES
+    /**
+     Runs several envelopes at once, one per SIMD lane, see VoiceLanes. Unlike
+     processBlock the envelope values are written to the output rather than
+     multiplied into it
+     */
+    static void processLanes(EnvelopeModule* const* envs, int numEnvs, float* output, int numSamples);
+   #endif
+    
     void reset() override;
     
     bool isActive();
@@ -77,6 +104,12 @@ private:
     
     double calcCoef(double rate, double targetRatio);
     
+    /** reads the schema values, called at the start of each block */
+    void updateParameters();
+    
+    /** advances the envelope by one sample and returns the gain to apply */
+    inline float getNextValue();
+    
     //MARK: members
     bool enabled;
     float sends = 1.0; //0 to 1.0 value
@@ -97,7 +130,7 @@ private:
     double sustainLevel;
     double targetRatioA;
     double targetRatioDR;
-    float currValue;
+    double currValue;
     float velocityMod=1.f;
     float noteVelocity= 1.f;
 
@@ -106,6 +139,6 @@ private:
     double decayBase;
     double releaseBase;
     double quickReleaseBase;
-    float samplerate;
+    float samplerate = 44100.f;
 };
 
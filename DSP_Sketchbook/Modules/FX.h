@@ -33,10 +33,29 @@ public:
     {
         return "Convolution";
     }
+    
+    /**
+     Replaces the impulse response with one held in memory. The swap happens on
+     a later call to process, once the background loader has prepared it
+     */
+    void loadImpulseResponse(juce::AudioBuffer<float>&& impulseResponse, double irSampleRate)
+    {
+        juceConvolution.loadImpulseResponse(std::move(impulseResponse), irSampleRate,
+                                            juce::dsp::Convolution::Stereo::yes,
+                                            juce::dsp::Convolution::Trim::no,
+                                            juce::dsp::Convolution::Normalise::yes);
+    }
+    
+    /** the length of the impulse response */
+    double getTailLengthSeconds() override
+    {
+        return double(juceConvolution.getCurrentIRSize()) / sampleRate;
+    }
 
     //==============================================================================
     void prepareToPlay (float samplerate, int buffersize) override
     {
+        sampleRate = double(samplerate);
         juce::dsp::ProcessSpec spec = {double(samplerate), juce::uint32(buffersize), juce::uint32(2)};
         juceConvolution.prepare(spec);
     }
@@ -58,6 +77,7 @@ public:
 private:
 
     juce::dsp::Convolution juceConvolution;
+    double sampleRate = 44100.0;
 };
 
 /*
@@ -231,45 +251,47 @@ private:
 class Distortion : public sketchbook::Module
 {
 public:
+    static constexpr auto parameters = sketchbook::makeParameterSchema(
+        sketchbook::ParameterSpec::Float("In Gain", 20.f, 0.f, 30.f),
+        sketchbook::ParameterSpec::Float("Out Gain", 20.f, -30.f, 30.f),
+        sketchbook::ParameterSpec::Float("Tone", 0.f, 0.f, 1.f));
+    
+    static constexpr int inGainParam  = parameters.indexOf("In Gain");
+    static constexpr int outGainParam = parameters.indexOf("Out Gain");
+    static constexpr int toneParam    = parameters.indexOf("Tone");
+    
     //==============================================================================
     Distortion()
     {
         auto& waveshaper = processorChain.template get<waveshaperIndex>();
         waveshaper.functionToUse = [] (float x)
                                    {
-                                       return std::tanh (x);
+                                       return sketchbook::FastMath::tanh (x);
                                    };
-
-        auto& preGain = processorChain.template get<preGainIndex>();
-        auto& postGain = processorChain.template get<postGainIndex>();
-        auto& filter = processorChain.template get<filterIndex>();
         
-        setModuleParameters({
-            
-            Parameter::Float("In Gain", [&] (juce::var value)
-            {
-                preGain.setGainDecibels (float(value));
-            }, 20.0, 0.0, 30.0),
-            
-            Parameter::Float("Out Gain", [&] (juce::var value)
-            {
-                postGain.setGainDecibels (float(value));
-            }, 20.0, -30.0, 30.0),
-            
-            Parameter::Float("Tone", [&] (juce::var value)
-            {
-                normToneValue = float(value);
-                filter.state = FilterCoefs::makeFirstOrderHighPass (samplerate, juce::NormalisableRange<float>(500, 20000, 1.0, 2000).convertFrom0to1(normToneValue));
-            }, 0.0, 0.0, 1.0),
-        });
+        setModuleParameters(parameters);
+        updateParameters();
     }
 
     //==============================================================================
-    void prepareToPlay (float samplerate, int buffersize) override
+    void prepareToPlay (float _samplerate, int buffersize) override
     {
-        samplerate = samplerate;
+        samplerate = _samplerate;
+        
+        //built here, as making coefficients allocates
+        toneTable.build(toneTableSize, sketchbook::FilterCoefficientTable::Shape::firstOrderHighPass,
+                        samplerate, juce::NormalisableRange<float>(500, 20000, 1.0, 2000));
+        
+        toneSmoother.prepare(samplerate, smoothingSeconds);
+        toneSmoother.setCurrentAndTarget(toneSmoother.getTarget());
+        
+        //allocated once, the table writes into these in place from then on
         auto& filter = processorChain.template get<filterIndex>();
-        filter.state = FilterCoefs::makeFirstOrderHighPass (samplerate, juce::NormalisableRange<float>(500, 20000, 1.0, 2000).convertFrom0to1(normToneValue));
+        filter.state = FilterCoefs::makeFirstOrderHighPass (samplerate, 500.f);
+        toneTable.lookup(toneSmoother.getCurrentValue(), *filter.state);
+        
+        processorChain.template get<preGainIndex>().setRampDurationSeconds(smoothingSeconds);
+        processorChain.template get<postGainIndex>().setRampDurationSeconds(smoothingSeconds);
 
         juce::dsp::ProcessSpec spec = {samplerate, juce::uint32(buffersize), 2};
         processorChain.prepare(spec);
@@ -279,8 +301,23 @@ public:
     void process(juce::AudioBuffer<float>& buffer) noexcept override
     {
         auto block = juce::dsp::AudioBlock<float>(buffer);
-        juce::dsp::ProcessContextReplacing<float> ctx(block);
-        processorChain.process(ctx);
+        auto& filter = processorChain.template get<filterIndex>();
+        const int numSamples = buffer.getNumSamples();
+        
+        updateParameters();
+        
+        //the tone filter is updated between sub blocks while its value is moving
+        for (int start = 0; start < numSamples; start += coefficientUpdateInterval)
+        {
+            const int numToProcess = juce::jmin(coefficientUpdateInterval, numSamples - start);
+            
+            if (toneSmoother.isSmoothing())
+                toneTable.lookup(toneSmoother.getNextRamp(numToProcess).end, *filter.state);
+            
+            auto subBlock = block.getSubBlock((size_t) start, (size_t) numToProcess);
+            juce::dsp::ProcessContextReplacing<float> ctx(subBlock);
+            processorChain.process(ctx);
+        }
     }
 
     //==============================================================================
@@ -305,7 +342,39 @@ private:
     };
 
     float samplerate=44100.f;
-    float normToneValue=1.f;
+    
+    //the gains last set, so the decibels are only converted when they change
+    float inGainDecibels = std::numeric_limits<float>::quiet_NaN();
+    float outGainDecibels = std::numeric_limits<float>::quiet_NaN();
+    
+    /** reads the schema values, called at the start of each block */
+    void updateParameters()
+    {
+        const float inGain  = getParameterValue(inGainParam);
+        const float outGain = getParameterValue(outGainParam);
+        
+        if (inGain != inGainDecibels)
+        {
+            inGainDecibels = inGain;
+            processorChain.template get<preGainIndex>().setGainDecibels(inGain);
+        }
+        
+        if (outGain != outGainDecibels)
+        {
+            outGainDecibels = outGain;
+            processorChain.template get<postGainIndex>().setGainDecibels(outGain);
+        }
+        
+        //the coefficients follow the smoothed value in process
+        toneSmoother.setTarget(getParameterValue(toneParam));
+    }
+    
+    static constexpr double smoothingSeconds = 0.02;
+    static constexpr int coefficientUpdateInterval = 32;
+    static constexpr int toneTableSize = 256;
+    
+    sketchbook::BlockSmoother toneSmoother;
+    sketchbook::FilterCoefficientTable toneTable;
     
     using Filter = juce::dsp::IIR::Filter<float>;
     using FilterCoefs = juce::dsp::IIR::Coefficients<float>;
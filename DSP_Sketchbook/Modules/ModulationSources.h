@@ -10,30 +10,27 @@
 
 #pragma once
 #include "../Engine/Module.h"
+#include "../Engine/FastMath.h"
 
 class LfoModule : public sketchbook::Module
 {
 public:
     
+    static constexpr auto parameters = sketchbook::makeParameterSchema(
+        sketchbook::ParameterSpec::Float("Rate Hz", 0.5f, 0.01f, 10.0f),
+        sketchbook::ParameterSpec::Float("Depth", 1.0f, 0.0f, 1.0f));
+    
+    static constexpr int rateParam  = parameters.indexOf("Rate Hz");
+    static constexpr int depthParam = parameters.indexOf("Depth");
+    
     LfoModule()
     : frequency(0.5f)
     , depth(1.0f)
     , phase(0.0f)
     , sampleRate(44100.0f)
     {
-        setModuleParameters(
-        {
-            Parameter::Float("Rate Hz", [this](juce::var value)
-            {
-                frequency = static_cast<float>(value);
-                updatePhaseIncrement();
-            }, 0.5, 0.01f, 10.0),
-
-            Parameter::Float("Depth", [this](juce::var value)
-            {
-                depth = static_cast<float>(value);
-            }, 1.0, 0.0f, 1.0)
-        });
+        setModuleParameters(parameters);
+        updateParameters();
     }
 
     virtual ~LfoModule() {}
@@ -61,14 +58,50 @@ public:
 
     void processSample(float* sample) override
     {
-        float lfoValue = depth * std::sin(phase);
-        *sample *= (1.f + lfoValue) / 2.f;  // Amplitude modulation
+        LfoModule::processBlock(sample, 0, 1);
+    }
+    
+    void processBlock(float* buffer, int startSample, int numSamples) override
+    {
+        if (numSamples <= 0)
+            return;
         
-        phase += phaseIncrement;
-        if (phase >= 2.0f * M_PI)
-            phase -= 2.0f * M_PI;
+        updateParameters();
         
-        internalBuffer.appendSingleSample(*sample);
+        float p = phase;
+        
+        for (int i = startSample; i < startSample + numSamples; i++)
+        {
+            float lfoValue = depth * sketchbook::FastMath::sin<sketchbook::FastMath::Accuracy::medium>(p);
+            buffer[i] *= (1.f + lfoValue) / 2.f;  // Amplitude modulation
+            
+            p += phaseIncrement;
+            if (p >= 2.0f * M_PI)
+                p -= 2.0f * M_PI;
+        }
+        
+        phase = p;
+        
+        //only the latest value is read by the modulation mappings
+        internalBuffer.appendSingleSample(buffer[startSample + numSamples - 1]);
+    }
+    
+    void processControl(int numSamples) override
+    {
+        if (numSamples <= 0)
+            return;
+        
+        updateParameters();
+        
+        //jump straight to the last sample of the stretch, as processBlock would end on
+        float p = std::fmod(phase + phaseIncrement * float(numSamples - 1), 2.0f * float(M_PI));
+        internalBuffer.appendSingleSample((1.f + depth * sketchbook::FastMath::sin<sketchbook::FastMath::Accuracy::medium>(p)) / 2.f);
+        
+        p += phaseIncrement;
+        if (p >= 2.0f * M_PI)
+            p -= 2.0f * M_PI;
+        
+        phase = p;
     }
 
     juce::String getName() override
@@ -78,6 +111,20 @@ public:
 
 private:
     
+    /** reads the schema values, the increment is only worked out again when the rate changes */
+    void updateParameters()
+    {
+        depth = getParameterValue(depthParam);
+        
+        const float rate = getParameterValue(rateParam);
+        
+        if (rate != frequency)
+        {
+            frequency = rate;
+            updatePhaseIncrement();
+        }
+    }
+    
     void updatePhaseIncrement()
     {
         phaseIncrement = 2.0f * M_PI * (frequency / sampleRate);
@@ -86,7 +133,7 @@ private:
     float frequency;
     float depth;
     float phase;
-    float phaseIncrement;
+    float phaseIncrement = 0.f;
     float sampleRate;
 };
 
@@ -16,28 +16,49 @@ namespace sketchbook
 class Reverb : public Module
 {
 public:
+    
+    //the dragonfly presets in bank order, see getPresetByIndex
+    static constexpr auto parameters = makeParameterSchema(
+        ParameterSpec::Choice("Preset", "Bright Room;Clear Room;Dark Room;Small Chamber;Large Chamber;"
+                                        "Acoustic Studio;Electric Studio;Percussion Studio;Piano Studio;Vocal Studio;"
+                                        "Small Bright Hall;Small Clear Hall;Small Dark Hall;Small Percussion Hall;Small Vocal Hall;"
+                                        "Medium Bright Hall;Medium Clear Hall;Medium Dark Hall;Medium Percussion Hall;Medium Vocal Hall;"
+                                        "Large Bright Hall;Large Clear Hall;Large Dark Hall;Large Vocal Hall;Great Hall", 0),
+        ParameterSpec::Float("wet", 0.5f, 0.f, 2.5f));
+    
+    static constexpr int presetParam = parameters.indexOf("Preset");
+    static constexpr int wetParam    = parameters.indexOf("wet");
+    
     Reverb()
     : dragonFlyReverb(samplerate)
     {
-        setModuleParameters({
-            
-            Parameter::Choice("Preset", [this] (juce::String value)
-            {
-                setPresetByName(value);
-            }, getPresetNames(), "Bright Room"),
-            
-            Parameter::Float("wet", [&] (juce::var value)
-            {
-                wet = float(value);
-            }, 0.5f, 0.f, 2.5f),
-
-        });
+       #if JUCE_DEBUG
+        //the options must list the presets as the banks do
+        const auto& options = parameters[presetParam].options;
+        const auto names = juce::StringArray::fromTokens(juce::String(options.data(), options.size()), ";", "");
+        jassert(names.size() == dragonfly::NUM_BANKS * dragonfly::PRESETS_PER_BANK);
+        
+        for (int i = 0; i < names.size(); i++)
+            jassert(names[i] == juce::String(getPresetByIndex(i)->name));
+       #endif
+        
+        setModuleParameters(parameters);
+        updateParameters();
     }
     
     juce::String getName() override
     {
         return "Dragon Fly Hall Reverb";
     }
+    
+    /** the predelay, then the decay time stretched from -60dB down to -100dB */
+    double getTailLengthSeconds() override
+    {
+        const double predelaySeconds = dragonFlyReverb.getParameterValue(dragonfly::paramPredelay) / 1000.0;
+        const double rt60 = dragonFlyReverb.getParameterValue(dragonfly::paramDecay);
+        
+        return predelaySeconds + rt60 * (100.0 / 60.0);
+    }
 
     //==============================================================================
     void prepareToPlay (float _samplerate, int _maxBufferSize) override
@@ -45,18 +66,24 @@ public:
         samplerate = _samplerate;
         dragonFlyReverb.sampleRateChanged(_samplerate);
         tmpBuffer.setSize(2, _maxBufferSize);
+        
+        wet.prepare(samplerate, 0.02);
+        wet.setCurrentAndTarget(getParameterValue(wetParam));
     }
 
     //==============================================================================
     void process (juce::AudioBuffer<float>& buffer) noexcept override
     {
+        updateParameters();
+        
         //run the reverb algo
         dragonFlyReverb.run(buffer.getArrayOfWritePointers(), tmpBuffer.getArrayOfWritePointers(), buffer.getNumSamples());
         
         //copy back to the buffer with wet dry mix
+        const auto wetRamp = wet.getNextRamp(buffer.getNumSamples());
+        
         for (int i = 0; i < buffer.getNumChannels(); i++)
-            for (int j = 0; j < buffer.getNumSamples(); j++)
-                buffer.getWritePointer(i)[j] += tmpBuffer.getWritePointer(i)[j] * wet;
+            wetRamp.addWithMultiply(buffer.getWritePointer(i), tmpBuffer.getReadPointer(i), buffer.getNumSamples());
     }
 
     //==============================================================================
@@ -70,24 +97,38 @@ private:
     float samplerate = 44100;
     dragonfly::DragonflyReverbDSP dragonFlyReverb;
     juce::AudioBuffer<float> tmpBuffer;
-    float wet = 1.f;
+    BlockSmoother wet;
+    int currentPreset = -1;
+    
+    /** reads the schema values, a preset is only loaded when the choice changes */
+    void updateParameters()
+    {
+        const int preset = getParameterValues().getInt(presetParam);
+        
+        if (preset != currentPreset)
+        {
+            currentPreset = preset;
+            setPresetByIndex(preset);
+        }
+        
+        wet.setTarget(getParameterValue(wetParam));
+    }
     
     // ===========================================================================
     // The following is an implementation of the Dragonfly Hall reverb parameters
     // ===========================================================================
-    const dragonfly::Preset* getPresetByName(juce::String name)
+    //presets are indexed in bank order, as listed in the Preset parameter
+    static const dragonfly::Preset* getPresetByIndex(int index)
     {
-        for (int i = 0; i < dragonfly::NUM_BANKS; i++)
-            for (int j = 0; j < dragonfly::PRESETS_PER_BANK; j++)
-                if (juce::String(dragonfly::banks[i].presets[j].name) == name)
-                    return &dragonfly::banks[i].presets[j];
+        if (!juce::isPositiveAndBelow(index, dragonfly::NUM_BANKS * dragonfly::PRESETS_PER_BANK))
+            return nullptr;
         
-        return nullptr;
+        return &dragonfly::banks[index / dragonfly::PRESETS_PER_BANK].presets[index % dragonfly::PRESETS_PER_BANK];
     }
     
-    void setPresetByName(juce::String name)
+    void setPresetByIndex(int index)
     {
-        if (auto* preset = getPresetByName(name))
+        if (auto* preset = getPresetByIndex(index))
         {
             for (uint32_t i = 0; i < dragonfly::Parameters::paramCount; i++)
             {
@@ -95,15 +136,5 @@ private:
             }
         }
     }
-    
-    static const juce::StringArray getPresetNames()
-    {
-        juce::StringArray output;
-        for (int i = 0; i < dragonfly::NUM_BANKS; i++)
-            for (int j = 0; j < dragonfly::PRESETS_PER_BANK; j++)
-                output.add(juce::String(dragonfly::banks[i].presets[j].name));
-        
-        return output;
-    }
 };
 } //end namespace sketchbook
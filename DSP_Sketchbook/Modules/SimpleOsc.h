@@ -10,6 +10,8 @@
 
 #pragma once
 #include "../Engine/Module.h"
+#include "../Engine/VoiceLanes.h"
+#include "../Engine/FastMath.h"
 
 namespace sketchbook
 {
@@ -17,43 +19,31 @@ namespace sketchbook
 class SimpleOsc : public sketchbook::Module
 {
 public:
+    
+    static constexpr auto parameters = makeParameterSchema(
+        ParameterSpec::Float("Pulse", 0.5f, 0.f, 1.f),
+        ParameterSpec::Float("Phase", 0.5f, 0.f, 1.f),
+        ParameterSpec::Float("Gain", 0.5f, 0.f, 1.f),
+        ParameterSpec::Boolean("Test Boolean", true),
+        ParameterSpec::Choice("Text Choice", "Item 1;Item 2;Item 3", 0),
+        ParameterSpec::Integer("Integer Test", 1, 0, 10));
+    
+    static constexpr int pulseParam = parameters.indexOf("Pulse");
+    static constexpr int phaseParam = parameters.indexOf("Phase");
+    static constexpr int gainParam  = parameters.indexOf("Gain");
+    
     //==============================================================================
     SimpleOsc()
     {
         setVoiceMonitorType(adsr);
         
-        setModuleParameters({
-            
-            Parameter::Float("Pulse", [&] (juce::var value)
-            {
-                m_pulseLen = float(value);
-            }, 0.5, 0.0, 1.0),
-            
-            Parameter::Float("Phase", [&] (juce::var value)
-            {
-                m_phaseOffset = float(value);
-            }, 0.5, 0.0, 1.0),
-            
-            Parameter::Float("Gain", [&] (juce::var value)
-            {
-                m_gain = float(value);
-            }, 0.5, 0.f, 1.0),
-            
-            Parameter::Boolean("Test Boolean", [this] (bool value)
-            {
-                DBG(juce::String("Test Boolean : ") + (value ? juce::String("True") : juce::String("False")));
-            }, true),
-            
-            Parameter::Choice("Text Choice", [this] (juce::String value)
-            {
-                DBG(juce::String("Test Choice : " + value));
-            }, {"Item 1", "Item 2", "Item 3"}, "Item 1"),
-            
-            Parameter::Integer("Integer Test", [this] (int value)
-            {
-                DBG(juce::String("Integer Value : ") + juce::String(value));
-            }, 1, 0, 10)
-        });
+        setModuleParameters(parameters);
+        
+        //phase and gain can follow a modulation source per sample
+        setAudioRateModulation("Phase");
+        setAudioRateModulation("Gain");
+        m_phaseModulation = getModifiedParam(phaseParam);
+        m_gainModulation  = getModifiedParam(gainParam);
     }
     
     void prepareToPlay(float samplerate, int buffersize) override
@@ -89,16 +79,155 @@ public:
     
     void processSample(float* sample) override
     {
-        const float alteredPhase = m_phase > m_pulseLen ? 0.f : m_phase * 1 / m_pulseLen;
-        *sample += std::sin(alteredPhase * juce::MathConstants<float>::twoPi) * m_gain;
-        *sample += std::sin((alteredPhase + m_phaseOffset) * juce::MathConstants<float>::twoPi) * m_gain;
+        SimpleOsc::processBlock(sample, 0, 1);
+    }
+    
+    void processBlock(float* buffer, int startSample, int numSamples) override
+    {
+        //work on local copies so the loop does not reload members
+        float phase = m_phase;
+        const float phaseInc = m_phaseInc;
+        
+        //ramps between control ticks, the values are worked out from the index so the steps do not accumulate
+        const BlockRamp pulseRamp = getParameterRamp(pulseParam);
+        const BlockRamp phaseRamp = getParameterRamp(phaseParam);
+        const BlockRamp gainRamp  = getParameterRamp(gainParam);
+        const float pulseIncrement = pulseRamp.getIncrement(numSamples);
+        const float phaseIncrement = phaseRamp.getIncrement(numSamples);
+        const float gainIncrement  = gainRamp.getIncrement(numSamples);
+        
+        //null unless modulated at audio rate
+        const float* phaseMod = m_phaseModulation->getModulationBuffer();
+        const float* gainMod  = m_gainModulation->getModulationBuffer();
+        
+        for (int i = 0; i < numSamples; i++)
+        {
+            const float pulseLen = pulseRamp.start + pulseIncrement * float(i);
+            const float g        = gainMod  != nullptr ? gainMod[i]  : gainRamp.start + gainIncrement * float(i);
+            const float offset   = phaseMod != nullptr ? phaseMod[i] : phaseRamp.start + phaseIncrement * float(i);
+            
+            const float alteredPhase = phase > pulseLen ? 0.f : phase / pulseLen;
+            buffer[startSample + i] += FastMath::sin2Pi(alteredPhase) * g;
+            buffer[startSample + i] += FastMath::sin2Pi(alteredPhase + offset) * g;
+            
+            //increment and wrap
+            phase += phaseInc;
+            if (phase >= 1.f)
+                phase -= 1.f;
+        }
         
-        //increment and wrap
-        m_phase += m_phaseInc;
-        if (m_phase >= 1.f)
-            m_phase -= 1.f;
+        m_phase = phase;
     }
     
+   #if SKETCHBOOK_VOICE_LANES
+    /**
+     Renders several oscillators at once, one per SIMD lane, see VoiceLanes.
+     Uses the same polynomial sine as processBlock, though the two may still
+     round differently
+     */
+    static void processLanes(SimpleOsc* const* oscs, int numOscs, float* output, int numSamples)
+    {
+        using Register = VoiceLanes::Register;
+        constexpr int numLanes = VoiceLanes::numLanes;
+        jassert(numOscs <= numLanes);
+        
+        //gather the state of each oscillator into its lane, unused lanes stay silent
+        auto phase       = Register::expand(0.f);
+        auto phaseInc    = Register::expand(0.f);
+        auto phaseOffset = Register::expand(0.f);
+        auto pulseLen    = Register::expand(0.f);
+        auto pulseScale  = Register::expand(0.f);
+        auto gain        = Register::expand(0.f);
+        
+        //parameters that move within the block, from audio rate modulation or a ramp
+        //between control ticks, are interleaved into lanes a stretch at a time
+        std::array<const float*, (size_t) numLanes> phaseMods {};
+        std::array<const float*, (size_t) numLanes> gainMods {};
+        std::array<const float*, (size_t) numLanes> pulseMods {};
+        std::array<BlockRamp, (size_t) numLanes> phaseRamps {};
+        std::array<BlockRamp, (size_t) numLanes> gainRamps {};
+        std::array<BlockRamp, (size_t) numLanes> pulseRamps {};
+        bool isPhaseMoving = false;
+        bool isGainMoving = false;
+        bool isPulseMoving = false;
+        
+        for (int k = 0; k < numOscs; k++)
+        {
+            auto& osc = *oscs[k];
+            phaseMods[(size_t) k]  = osc.m_phaseModulation->getModulationBuffer();
+            gainMods[(size_t) k]   = osc.m_gainModulation->getModulationBuffer();
+            phaseRamps[(size_t) k] = osc.getParameterRamp(phaseParam);
+            gainRamps[(size_t) k]  = osc.getParameterRamp(gainParam);
+            pulseRamps[(size_t) k] = osc.getParameterRamp(pulseParam);
+            
+            isPhaseMoving = isPhaseMoving || phaseMods[(size_t) k] != nullptr || !phaseRamps[(size_t) k].isConstant();
+            isGainMoving  = isGainMoving  || gainMods[(size_t) k] != nullptr  || !gainRamps[(size_t) k].isConstant();
+            isPulseMoving = isPulseMoving || !pulseRamps[(size_t) k].isConstant();
+        }
+        
+        for (int k = 0; k < numOscs; k++)
+        {
+            phase.set((size_t) k, oscs[k]->m_phase);
+            phaseInc.set((size_t) k, oscs[k]->m_phaseInc);
+            const float oscPulseLen = pulseRamps[(size_t) k].start;
+            
+            phaseOffset.set((size_t) k, phaseRamps[(size_t) k].start);
+            pulseLen.set((size_t) k, oscPulseLen);
+            pulseScale.set((size_t) k, oscPulseLen > 0.f ? 1.f / oscPulseLen : 0.f);
+            gain.set((size_t) k, gainRamps[(size_t) k].start);
+        }
+        
+        constexpr int gatherSize = 32;
+        alignas(sizeof(Register)) float phaseOffsetLanes[gatherSize * numLanes];
+        alignas(sizeof(Register)) float gainLanes[gatherSize * numLanes];
+        alignas(sizeof(Register)) float pulseLenLanes[gatherSize * numLanes];
+        alignas(sizeof(Register)) float pulseScaleLanes[gatherSize * numLanes];
+        
+        for (int stretchStart = 0; stretchStart < numSamples; stretchStart += gatherSize)
+        {
+            const int stretchSize = juce::jmin(gatherSize, numSamples - stretchStart);
+            
+            if (isPhaseMoving)
+                VoiceLanes::interleave(phaseMods.data(), phaseRamps.data(), numSamples, stretchStart, stretchSize, phaseOffsetLanes);
+            
+            if (isGainMoving)
+                VoiceLanes::interleave(gainMods.data(), gainRamps.data(), numSamples, stretchStart, stretchSize, gainLanes);
+            
+            if (isPulseMoving)
+            {
+                VoiceLanes::interleave(pulseMods.data(), pulseRamps.data(), numSamples, stretchStart, stretchSize, pulseLenLanes);
+                
+                for (int j = 0; j < stretchSize * numLanes; j++)
+                    pulseScaleLanes[j] = pulseLenLanes[j] > 0.f ? 1.f / pulseLenLanes[j] : 0.f;
+            }
+            
+            for (int j = 0; j < stretchSize; j++)
+            {
+                if (isPhaseMoving) phaseOffset = Register::fromRawArray(phaseOffsetLanes + j * numLanes);
+                if (isGainMoving)  gain = Register::fromRawArray(gainLanes + j * numLanes);
+                
+                if (isPulseMoving)
+                {
+                    pulseLen   = Register::fromRawArray(pulseLenLanes + j * numLanes);
+                    pulseScale = Register::fromRawArray(pulseScaleLanes + j * numLanes);
+                }
+                
+                const auto alteredPhase = (phase * pulseScale) & Register::lessThanOrEqual(phase, pulseLen);
+                const auto offsetPhase  = VoiceLanes::wrapUnit(alteredPhase + phaseOffset);
+                
+                const auto out = (VoiceLanes::sin2Pi(alteredPhase) + VoiceLanes::sin2Pi(offsetPhase)) * gain;
+                out.copyToRawArray(output + (stretchStart + j) * numLanes);
+                
+                //increment and wrap
+                phase = VoiceLanes::wrapUnit(phase + phaseInc);
+            }
+        }
+        
+        for (int k = 0; k < numOscs; k++)
+            oscs[k]->m_phase = phase.get((size_t) k);
+    }
+   #endif
+    
     juce::String getName() override
     {
         return "Simple Osc";
@@ -110,8 +239,8 @@ private:
     float m_freqHz = 0;
     float m_phase = 0;
     float m_phaseInc = 0;
-    float m_phaseOffset=0;
-    float m_pulseLen = 0;
-    float m_gain = 0;
+    
+    std::shared_ptr<ModifiedParameter> m_phaseModulation;
+    std::shared_ptr<ModifiedParameter> m_gainModulation;
 };
 } // end namespace sketchbook
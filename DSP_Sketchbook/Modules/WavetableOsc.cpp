@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    WavetableOsc.cpp
+    Created: 16 Oct 2026 11:59:48pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include "WavetableOsc.h"
+
+namespace sketchbook
+{
+
+namespace
+{
+//the amplitude of harmonic k, before the shape is normalised
+double getHarmonicAmplitude(int shape, int k)
+{
+    const bool isOdd = k % 2 == 1;
+    
+    switch (shape)
+    {
+        case WavetableBank::sine:     return k == 1 ? 1.0 : 0.0;
+        case WavetableBank::saw:      return (isOdd ? 1.0 : -1.0) / double(k);
+        case WavetableBank::square:   return isOdd ? 1.0 / double(k) : 0.0;
+        case WavetableBank::triangle: return isOdd ? ((k / 2) % 2 == 0 ? 1.0 : -1.0) / double(k * k) : 0.0;
+        default:                      return 0.0;
+    }
+}
+} //end anonymous namespace
+
+const WavetableBank& WavetableBank::getShared()
+{
+    static const WavetableBank bank;
+    return bank;
+}
+
+WavetableBank::WavetableBank()
+: tables((size_t) (numShapes * numLevels * tableStride))
+{
+    //harmonics are read from one cycle of a sine at whole number steps, so building needs no trig per harmonic
+    std::vector<double> sine((size_t) tableSize);
+    
+    for (int n = 0; n < tableSize; n++)
+        sine[(size_t) n] = std::sin(juce::MathConstants<double>::twoPi * double(n) / double(tableSize));
+    
+    std::vector<double> cycle((size_t) tableSize);
+    
+    for (int shape = 0; shape < numShapes; shape++)
+    {
+        //every level of a shape is scaled by the same amount, so they are equally loud
+        double scale = 1.0;
+        
+        for (int level = 0; level < numLevels; level++)
+        {
+            const int numHarmonics = (tableSize / 2) >> level;
+            std::fill(cycle.begin(), cycle.end(), 0.0);
+            
+            for (int k = 1; k <= numHarmonics; k++)
+            {
+                const double amplitude = getHarmonicAmplitude(shape, k);
+                
+                if (amplitude == 0.0)
+                    continue;
+                
+                for (int n = 0; n < tableSize; n++)
+                    cycle[(size_t) n] += amplitude * sine[(size_t) ((k * n) & (tableSize - 1))];
+            }
+            
+            if (level == 0)
+            {
+                double peak = 0.0;
+                
+                for (auto value : cycle)
+                    peak = juce::jmax(peak, std::abs(value));
+                
+                scale = peak > 0.0 ? 1.0 / peak : 1.0;
+            }
+            
+            auto* table = tables.data() + (size_t) ((shape * numLevels + level) * tableStride + 1);
+            
+            for (int n = 0; n < tableSize; n++)
+                table[n] = float(cycle[(size_t) n] * scale);
+            
+            table[-1] = table[tableSize - 1];
+            table[tableSize] = table[0];
+            table[tableSize + 1] = table[1];
+        }
+    }
+}
+    
+} //end namespace sketchbook
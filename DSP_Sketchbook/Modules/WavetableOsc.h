@@ -0,0 +1,332 @@
+/*
+  ==============================================================================
+
+    WavetableOsc.h
+    Created: 16 Oct 2026 11:59:48pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "../Engine/Module.h"
+#include "../Engine/VoiceLanes.h"
+
+namespace sketchbook
+{
+
+/**
+ Band limited single cycle tables for the WavetableOsc shapes, with one mip
+ level per octave. Level 0 holds every harmonic the table can, each level up
+ holds half as many, so there is always a level whose harmonics all stay
+ below Nyquist.
+ 
+ The bank is built once per process, on first use, and only read after that,
+ so every voice of every plugin instance shares the same tables.
+ */
+class WavetableBank
+{
+    public:
+    
+    enum Shape
+    {
+        sine = 0, saw, square, triangle, numShapes
+    };
+    
+    static constexpr int tableSize = 2048;
+    static constexpr int numLevels = 11;
+    
+    /** the shared bank, built on the first call, which should not be on the audio thread */
+    static const WavetableBank& getShared();
+    
+    /**
+     One cycle of a shape at a mip level. It can be read from index -1 up to
+     tableSize + 1, so interpolation never has to wrap
+     */
+    const float* getTable(int shape, int level) const
+    {
+        jassert(juce::isPositiveAndBelow(shape, (int) numShapes) && juce::isPositiveAndBelow(level, numLevels));
+        return tables.data() + (size_t) ((shape * numLevels + level) * tableStride + 1);
+    }
+    
+    /** the level with the most harmonics that all stay below Nyquist, for a phase increment in cycles per sample */
+    static int getLevelForIncrement(float phaseInc)
+    {
+        //level l holds (tableSize / 2) >> l harmonics
+        const float highestHarmonic = phaseInc * float(tableSize / 2);
+        
+        if (highestHarmonic <= 0.5f)
+            return 0;
+        
+        return juce::jmin(numLevels - 1, (int) std::ceil(std::log2(highestHarmonic * 2.f)));
+    }
+    
+    private:
+    
+    WavetableBank();
+    
+    //one guard point before the cycle and two after it
+    static constexpr int tableStride = tableSize + 3;
+    
+    std::vector<float> tables;
+    
+    JUCE_DECLARE_NON_COPYABLE(WavetableBank)
+};
+
+//==============================================================================
+/**
+ An oscillator that reads band limited tables from the shared WavetableBank,
+ picking the mip level from the pitch so it does not alias. The inner loop
+ is a table read and an interpolation, with no trig
+ */
+class WavetableOsc : public sketchbook::Module
+{
+public:
+    
+    static constexpr auto parameters = makeParameterSchema(
+        ParameterSpec::Choice("Shape", "Sine;Saw;Square;Triangle", 1),
+        ParameterSpec::Choice("Interpolation", "Cubic;Linear", 0),
+        ParameterSpec::Float("Gain", 0.5f, 0.f, 1.f));
+    
+    static constexpr int shapeParam         = parameters.indexOf("Shape");
+    static constexpr int interpolationParam = parameters.indexOf("Interpolation");
+    static constexpr int gainParam          = parameters.indexOf("Gain");
+
+    //==============================================================================
+    WavetableOsc()
+    : bank(WavetableBank::getShared())
+    {
+        setVoiceMonitorType(adsr);
+        
+        setModuleParameters(parameters);
+        
+        setAudioRateModulation("Gain");
+        m_gainModulation = getModifiedParam(gainParam);
+    }
+    
+    void prepareToPlay(float samplerate, int buffersize) override
+    {
+        m_samplerate = samplerate;
+        setFrequency(m_freqHz);
+    }
+    
+    void noteOn(const sketchbook::NoteOnEvent& event) override
+    {
+        if (!event.isLegatoNoteOn)
+        {
+            m_phase = 0;
+            setFrequency(float(juce::MidiMessage::getMidiNoteInHertz(event.midiMessage.getNoteNumber())));
+        }
+    }
+    
+    void noteOff(bool) override
+    {
+        return;
+    }
+    
+    void reset() override
+    {
+        return;
+    }
+    
+    void pitchUpdated(float pitchHz) override
+    {
+        //called for every chunk, the mip level is only looked up again when the pitch moves
+        if (pitchHz != m_freqHz)
+            setFrequency(pitchHz);
+    }
+    
+    void processSample(float* sample) override
+    {
+        WavetableOsc::processBlock(sample, 0, 1);
+    }
+    
+    void processBlock(float* buffer, int startSample, int numSamples) override
+    {
+        const int shape = juce::jlimit(0, WavetableBank::numShapes - 1, (int) getParameterValue(shapeParam));
+        const float* table = bank.getTable(shape, m_level);
+        const BlockRamp gainRamp = getParameterRamp(gainParam);
+        
+        //null unless modulated at audio rate
+        const float* gainMod = m_gainModulation->getModulationBuffer();
+        
+        if (getParameterValue(interpolationParam) < 0.5f)
+            m_phase = render<true>(table, m_phase, m_phaseInc, gainRamp, gainMod, buffer + startSample, numSamples);
+        else
+            m_phase = render<false>(table, m_phase, m_phaseInc, gainRamp, gainMod, buffer + startSample, numSamples);
+    }
+    
+   #if SKETCHBOOK_VOICE_LANES
+    /**
+     Renders several oscillators at once, one per SIMD lane, see VoiceLanes.
+     Each lane reads its own table at its own phase, so the table reads are
+     gathered a lane at a time into interleaved stretches, and the
+     interpolation and gain then run across all the lanes together
+     */
+    static void processLanes(WavetableOsc* const* oscs, int numOscs, float* output, int numSamples)
+    {
+        using Register = VoiceLanes::Register;
+        using Mask = VoiceLanes::Mask;
+        constexpr int numLanes = VoiceLanes::numLanes;
+        jassert(numOscs <= numLanes);
+        
+        std::array<const float*, (size_t) numLanes> tables {};
+        std::array<const float*, (size_t) numLanes> gainMods {};
+        std::array<BlockRamp, (size_t) numLanes> gainRamps {};
+        auto gain = Register::expand(0.f);
+        auto isCubic = Mask::expand(0);
+        bool isGainMoving = false;
+        
+        for (int k = 0; k < numOscs; k++)
+        {
+            auto& osc = *oscs[k];
+            const int shape = juce::jlimit(0, WavetableBank::numShapes - 1, (int) osc.getParameterValue(shapeParam));
+            
+            tables[(size_t) k]    = osc.bank.getTable(shape, osc.m_level);
+            gainMods[(size_t) k]  = osc.m_gainModulation->getModulationBuffer();
+            gainRamps[(size_t) k] = osc.getParameterRamp(gainParam);
+            
+            gain.set((size_t) k, gainRamps[(size_t) k].start);
+            isCubic.set((size_t) k, osc.getParameterValue(interpolationParam) < 0.5f ? 0xffffffffu : 0u);
+            isGainMoving = isGainMoving || gainMods[(size_t) k] != nullptr || !gainRamps[(size_t) k].isConstant();
+        }
+        
+        //the four points around each read and how far between the middle two it lies,
+        //unused lanes are never written so they stay silent
+        constexpr int gatherSize = 32;
+        alignas(sizeof(Register)) float beforeLanes[gatherSize * numLanes] {};
+        alignas(sizeof(Register)) float currentLanes[gatherSize * numLanes] {};
+        alignas(sizeof(Register)) float nextLanes[gatherSize * numLanes] {};
+        alignas(sizeof(Register)) float afterLanes[gatherSize * numLanes] {};
+        alignas(sizeof(Register)) float fracLanes[gatherSize * numLanes] {};
+        alignas(sizeof(Register)) float gainLanes[gatherSize * numLanes];
+        
+        const auto half = Register::expand(0.5f);
+        
+        for (int stretchStart = 0; stretchStart < numSamples; stretchStart += gatherSize)
+        {
+            const int stretchSize = juce::jmin(gatherSize, numSamples - stretchStart);
+            
+            //the read position follows the phase, so each lane is stepped on its own, as in render
+            for (int k = 0; k < numOscs; k++)
+            {
+                auto& osc = *oscs[k];
+                const float* table = tables[(size_t) k];
+                const float phaseInc = osc.m_phaseInc;
+                float phase = osc.m_phase;
+                
+                for (int j = 0; j < stretchSize; j++)
+                {
+                    const float position = phase * float(WavetableBank::tableSize);
+                    const int index = int(position);
+                    const float* p = table + index;
+                    const int lane = j * numLanes + k;
+                    
+                    beforeLanes[lane]  = p[-1];
+                    currentLanes[lane] = p[0];
+                    nextLanes[lane]    = p[1];
+                    afterLanes[lane]   = p[2];
+                    fracLanes[lane]    = position - float(index);
+                    
+                    //increment and wrap
+                    phase += phaseInc;
+                    if (phase >= 1.f)
+                        phase -= 1.f;
+                }
+                
+                osc.m_phase = phase;
+            }
+            
+            if (isGainMoving)
+                VoiceLanes::interleave(gainMods.data(), gainRamps.data(), numSamples, stretchStart, stretchSize, gainLanes);
+            
+            for (int j = 0; j < stretchSize; j++)
+            {
+                const auto before  = Register::fromRawArray(beforeLanes + j * numLanes);
+                const auto current = Register::fromRawArray(currentLanes + j * numLanes);
+                const auto next    = Register::fromRawArray(nextLanes + j * numLanes);
+                const auto after   = Register::fromRawArray(afterLanes + j * numLanes);
+                const auto frac    = Register::fromRawArray(fracLanes + j * numLanes);
+                
+                if (isGainMoving)
+                    gain = Register::fromRawArray(gainLanes + j * numLanes);
+                
+                const auto linear = current + frac * (next - current);
+                
+                //catmull-rom, as in render
+                const auto c1 = half * (next - before);
+                const auto c2 = before - Register::expand(2.5f) * current + Register::expand(2.f) * next - half * after;
+                const auto c3 = half * (after - before) + Register::expand(1.5f) * (current - next);
+                const auto cubic = ((c3 * frac + c2) * frac + c1) * frac + current;
+                
+                (VoiceLanes::select(isCubic, cubic, linear) * gain).copyToRawArray(output + (stretchStart + j) * numLanes);
+            }
+        }
+    }
+   #endif
+    
+    juce::String getName() override
+    {
+        return "Wavetable Osc";
+    }
+
+private:
+    
+    void setFrequency(float freqHz)
+    {
+        m_freqHz = freqHz;
+        m_phaseInc = m_samplerate > 0.f ? m_freqHz / m_samplerate : 0.f;
+        m_level = WavetableBank::getLevelForIncrement(m_phaseInc);
+    }
+    
+    //the interpolation is chosen once per block, so the loop itself does not branch on it
+    template <bool IsCubic>
+    static float render(const float* table, float phase, float phaseInc, BlockRamp gainRamp, const float* gainMod,
+                        float* output, int numSamples)
+    {
+        const float gainIncrement = gainRamp.getIncrement(numSamples);
+        
+        for (int i = 0; i < numSamples; i++)
+        {
+            const float position = phase * float(WavetableBank::tableSize);
+            const int index = int(position);
+            const float frac = position - float(index);
+            const float* p = table + index;
+            
+            float sample;
+            
+            if constexpr (IsCubic)
+            {
+                //catmull-rom through the points either side
+                const float c1 = 0.5f * (p[1] - p[-1]);
+                const float c2 = p[-1] - 2.5f * p[0] + 2.f * p[1] - 0.5f * p[2];
+                const float c3 = 0.5f * (p[2] - p[-1]) + 1.5f * (p[0] - p[1]);
+                sample = ((c3 * frac + c2) * frac + c1) * frac + p[0];
+            }
+            else
+            {
+                sample = p[0] + frac * (p[1] - p[0]);
+            }
+            
+            output[i] += sample * (gainMod != nullptr ? gainMod[i] : gainRamp.start + gainIncrement * float(i));
+            
+            //increment and wrap
+            phase += phaseInc;
+            if (phase >= 1.f)
+                phase -= 1.f;
+        }
+        
+        return phase;
+    }
+    
+    const WavetableBank& bank;
+    
+    float m_samplerate = 0;
+    float m_freqHz = 0;
+    float m_phase = 0;
+    float m_phaseInc = 0;
+    int m_level = 0;
+    
+    std::shared_ptr<ModifiedParameter> m_gainModulation;
+};
+} // end namespace sketchbook
@@ -692,6 +692,109 @@ class Pages  : public juce::Component
         }
     };
     
+    /**
+     Shows how much of real time the engine uses, and each module's share of
+     that, from the counts kept by the engine's ModuleProfiler
+     */
+    class PerformancePage : public juce::Component, private juce::Timer
+    {
+        public:
+        
+        PerformancePage(Context& _ctx)
+        : ctx(_ctx)
+        {
+            startTimerHz(10);
+        }
+        
+        void paint(juce::Graphics& g) override
+        {
+            auto area = getLocalBounds().reduced(6, 0);
+            g.setFont(juce::FontOptions("Andale Mono", 14.f, juce::Font::plain));
+            
+            if (!ModuleProfiler::isEnabled() || ctx.moduleProfiler == nullptr)
+            {
+                g.setColour(juce::Colour(220, 220, 220));
+                g.drawText("Build with SKETCHBOOK_ENABLE_PROFILING=1 to time the modules", area.removeFromTop(rowHeight),
+                           juce::Justification::centred);
+                return;
+            }
+            
+            auto& profiler = *ctx.moduleProfiler;
+            const int engineId = profiler.getProbeId(ModuleProfiler::engineProbeName);
+            const float engineLoad = juce::isPositiveAndBelow(engineId, (int) loads.size()) ? loads[(size_t) engineId] : 0.f;
+            
+            for (int i = 0; i < (int) loads.size(); i++)
+            {
+                //the engine is shown against real time, everything else against the engine
+                const float share = i == engineId ? engineLoad : (engineLoad > 0.f ? loads[(size_t) i] / engineLoad : 0.f);
+                const auto label = i == engineId ? juce::String("of real time") : juce::String("of engine");
+                
+                auto row = area.removeFromTop(rowHeight).reduced(0, 3);
+                
+                g.setColour(juce::Colour::fromRGB(25, 25, 25));
+                g.fillRoundedRectangle(row.toFloat(), 4);
+                
+                auto nameArea = row.removeFromLeft(row.getWidth() / 3).reduced(8, 0);
+                auto valueArea = row.removeFromRight(row.getWidth() / 3).reduced(8, 0);
+                auto barArea = row.reduced(0, 6).toFloat();
+                
+                g.setColour(juce::Colour(60, 60, 60));
+                g.fillRoundedRectangle(barArea, 3);
+                
+                g.setColour(juce::Colour(220, 220, 220));
+                g.fillRoundedRectangle(barArea.withWidth(barArea.getWidth() * juce::jlimit(0.f, 1.f, share)), 3);
+                
+                g.drawText(profiler.getProbeName(i), nameArea, juce::Justification::centredLeft);
+                g.drawText(juce::String(share * 100.f, 1) + "% " + label, valueArea, juce::Justification::centredRight);
+            }
+        }
+        
+        private:
+        
+        //how much of the time since the last read each probe used, smoothed
+        void timerCallback() override
+        {
+            if (ctx.moduleProfiler == nullptr || !ModuleProfiler::isEnabled())
+                return;
+            
+            auto& profiler = *ctx.moduleProfiler;
+            const auto now = ModuleProfiler::readCycleCounter();
+            const auto numProbes = (size_t) profiler.getNumProbes();
+            
+            if (lastCycles.size() != numProbes)
+            {
+                lastCycles.assign(numProbes, 0);
+                loads.assign(numProbes, 0.f);
+                lastReadTime = 0;
+            }
+            
+            for (size_t i = 0; i < numProbes; i++)
+            {
+                const auto cycles = profiler.getCycles((int) i);
+                
+                if (lastReadTime != 0 && now > lastReadTime)
+                {
+                    const float load = float(double(cycles - lastCycles[i]) / double(now - lastReadTime));
+                    loads[i] += (load - loads[i]) * 0.2f;
+                }
+                
+                lastCycles[i] = cycles;
+            }
+            
+            lastReadTime = now;
+            repaint();
+        }
+        
+        static constexpr int rowHeight = 32;
+        
+        Context& ctx;
+        std::vector<juce::uint64> lastCycles;
+        std::vector<float> loads;
+        juce::uint64 lastReadTime = 0;
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PerformancePage)
+    };
+    
     class ModulationsPage : public juce::ListBox, public juce::ListBoxModel, public juce::ValueTree::Listener
     {
         class ModulationRow : public juce::Component, public juce::ValueTree::Listener
@@ -914,17 +1017,20 @@ class Pages  : public juce::Component
     , modulationSourcesPage(_ctx)
     , modulationsPage(_ctx)
     , fxPage(_ctx)
+    , performancePage(_ctx)
     , ctx(_ctx)
     {
         pageList.add(&parametersPage);
         pageList.add(&modulationsPage);
         pageList.add(&modulationSourcesPage);
         pageList.add(&fxPage);
+        pageList.add(&performancePage);
         
         addChildComponent(parametersPage);
         addChildComponent(modulationsPage);
         addChildComponent(modulationSourcesPage);
         addChildComponent(fxPage);
+        addChildComponent(performancePage);
         
         setColour(juce::TabbedComponent::ColourIds::backgroundColourId, juce::Colours::white.withAlpha(0.f));
         
@@ -971,6 +1077,7 @@ class Pages  : public juce::Component
     ModulationSourcesPage modulationSourcesPage;
     ModulationsPage modulationsPage;
     FXPage fxPage;
+    PerformancePage performancePage;
     juce::Array<juce::Component*> pageList;
     int selectedPage = 0;
     Context& ctx;
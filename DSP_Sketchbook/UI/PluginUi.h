@@ -296,7 +296,7 @@ class MainPanelComponent : public juce::Component
             
             sp->pages.showPage(index);
         };
-        pageMenu.addOptions({"PARAMETERS", "MAPPINGS", "MODULATION SOURCES", "EFFECTS"});
+        pageMenu.addOptions({"PARAMETERS", "MAPPINGS", "MODULATION SOURCES", "EFFECTS", "PERFORMANCE"});
         pageMenu.select(0);
         
         addAndMakeVisible(header);
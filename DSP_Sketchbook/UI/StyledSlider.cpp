@@ -11,6 +11,7 @@
 #include "StyledSlider.h"
 #include "PluginUi.h"
 #include "../Engine/Module.h"
+#include "../Engine/ModulationTelemetry.h"
 
 //TODO: remove access to the main editor
 #include "../App/PluginEditor.h"
@@ -30,6 +31,7 @@ void ModableWidget::setData(juce::ValueTree _data)
     data.addListener(this);
     moduleName = juce::Identifier(data.getParent().getParent()[Module::ParamIdents::NAME]);
     paramName  = juce::Identifier(data[Module::ParamIdents::PARAMETER_NAME]);
+    telemetryId = -1;
 }
 
 void ModableWidget::setModulationValue(float value)
@@ -48,15 +50,14 @@ void ModableWidget::setDisplayModulation (bool _shouldDisplay)
     
     if (shouldDisplay && !vBlank)
     {
+        //looked up once here, each frame then just reads the latest snapshot
+        if (telemetryId < 0 && ctx.modulationTelemetry != nullptr)
+            telemetryId = ctx.modulationTelemetry->getParameterId(moduleName.toString(), paramName.toString());
+        
         vBlank.reset(new juce::VBlankAttachment(comp, [this] (double)
         {
-            if (auto mod = ctx.getLatestPlayingModuleByName(moduleName.toString()))
-            {
-                if (auto param = mod->getModifiedParam(paramName))
-                {
-                    setModulationValue(param->getModulatedValue());
-                }
-            }
+            if (telemetryId >= 0)
+                setModulationValue(ctx.modulationTelemetry->getValue(telemetryId));
             
             if (shouldDisplayModulation())
                 comp->repaint();
@@ -51,6 +51,7 @@ class ModableWidget : juce::ValueTree::Listener
     bool  shouldDisplay = false;
     float modulatedValue = 1.f;
     bool  isCentered = false;
+    int   telemetryId = -1;
     Context& ctx;
 };
 
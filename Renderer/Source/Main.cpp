@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 16 Oct 2026 10:52:18pm
+    Author:  William James
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+
+namespace
+{
+using namespace sketchbook;
+
+//the configuration to render, this should match the plugin's
+using Engine = AudioEngine<ModuleList<SimpleOsc>, ModuleList<Oversampled<Distortion, 4>, Reverb>>;
+
+void printUsage()
+{
+    std::cout << "usage: Sketchbook_Render --midi <file or folder> [--state <file or folder>] --out <wav file or folder>" << std::endl
+              << "                         [--samplerate 48000] [--blocksize 512] [--tail 2] [--bits 24]" << std::endl
+              << "                         [--max-speed] [--threads <n>]" << std::endl
+              << std::endl
+              << "--midi and --state may be given more than once. Every midi file is rendered" << std::endl
+              << "through every state, into the --out folder unless there is only one render." << std::endl
+              << "--max-speed runs renders in parallel, one per core unless --threads is given." << std::endl;
+}
+
+//a folder is expanded to the files in it with the given extensions
+void addFiles(juce::Array<juce::File>& dest, const juce::File& fileOrFolder, const juce::String& wildcard)
+{
+    if (fileOrFolder.isDirectory())
+    {
+        auto files = fileOrFolder.findChildFiles(juce::File::findFiles, false, wildcard);
+        files.sort();
+        dest.addArray(files);
+    }
+    else
+    {
+        dest.add(fileOrFolder);
+    }
+}
+
+struct Options
+{
+    juce::Array<juce::File> midiFiles;
+    juce::Array<juce::File> stateFiles;
+    juce::File output;
+    RenderSettings settings;
+    bool maxSpeed = false;
+    int numThreads = 0;
+};
+
+bool parseOptions(const juce::StringArray& args, Options& options)
+{
+    for (int i = 0; i < args.size(); i++)
+    {
+        const auto& arg = args[i];
+        
+        if (arg == "--max-speed")
+        {
+            options.maxSpeed = true;
+            continue;
+        }
+        
+        //every other option takes a value
+        if (i + 1 >= args.size())
+            return false;
+        
+        const auto value = args[++i];
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        
+        if (arg == "--midi")
+            addFiles(options.midiFiles, file, "*.mid;*.midi");
+        else if (arg == "--state")
+            addFiles(options.stateFiles, file, "*.xml");
+        else if (arg == "--out")
+            options.output = file;
+        else if (arg == "--samplerate")
+            options.settings.sampleRate = value.getDoubleValue();
+        else if (arg == "--blocksize")
+            options.settings.blockSize = value.getIntValue();
+        else if (arg == "--tail")
+            options.settings.tailSeconds = value.getDoubleValue();
+        else if (arg == "--bits")
+            options.settings.bitDepth = value.getIntValue();
+        else if (arg == "--threads")
+            options.numThreads = value.getIntValue();
+        else
+            return false;
+    }
+    
+    return !options.midiFiles.isEmpty() && options.output != juce::File()
+        && options.settings.sampleRate > 0.0 && options.settings.blockSize > 0;
+}
+
+juce::Array<RenderJob> makeJobs(const Options& options)
+{
+    juce::Array<RenderJob> jobs;
+    
+    //no state renders the default one
+    auto stateFiles = options.stateFiles;
+    
+    if (stateFiles.isEmpty())
+        stateFiles.add(juce::File());
+    
+    const bool isSingleRender = options.midiFiles.size() * stateFiles.size() == 1;
+    const bool isOutputFile = isSingleRender && options.output.hasFileExtension("wav");
+    
+    for (auto& midiFile : options.midiFiles)
+    {
+        for (auto& stateFile : stateFiles)
+        {
+            RenderJob job;
+            job.midiFile = midiFile;
+            job.stateFile = stateFile;
+            
+            if (isOutputFile)
+            {
+                job.outputFile = options.output;
+            }
+            else
+            {
+                auto name = midiFile.getFileNameWithoutExtension();
+                
+                if (stateFile != juce::File())
+                    name << "_" << stateFile.getFileNameWithoutExtension();
+                
+                job.outputFile = options.output.getChildFile(name + ".wav");
+            }
+            
+            jobs.add(job);
+        }
+    }
+    
+    return jobs;
+}
+} //end anonymous namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    
+    juce::StringArray args;
+    
+    for (int i = 1; i < argc; i++)
+        args.add(argv[i]);
+    
+    Options options;
+    
+    if (!parseOptions(args, options))
+    {
+        printUsage();
+        return 1;
+    }
+    
+    const auto jobs = makeJobs(options);
+    
+    if (!(jobs.size() == 1 && options.output.hasFileExtension("wav")) && !options.output.createDirectory())
+    {
+        std::cout << "could not create " << options.output.getFullPathName() << std::endl;
+        return 1;
+    }
+    
+    const OfflineRenderer<Engine> renderer(options.settings);
+    const double startTime = juce::Time::getMillisecondCounterHiRes();
+    
+    const auto results = renderer.renderAll(jobs, options.maxSpeed ? options.numThreads : 1);
+    
+    const double wallClockSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    std::cout << OfflineRender::getStatistics(results, wallClockSeconds);
+    
+    for (auto& result : results)
+        if (result.result.failed())
+            return 1;
+    
+    return 0;
+}
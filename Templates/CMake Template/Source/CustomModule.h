@@ -74,14 +74,28 @@ public:
     
     void processSample(float* sample) override
     {
-        const float alteredPhase = m_phase > m_pulseLen ? 0.f : m_phase * 1 / m_pulseLen;
-        *sample += std::sin(alteredPhase * juce::MathConstants<float>::twoPi) * m_gain;
-        *sample += std::sin((alteredPhase + m_phaseOffset) * juce::MathConstants<float>::twoPi) * m_gain;
+        CustomModule::processBlock(sample, 0, 1);
+    }
+    
+    //called by the voice with a run of samples to add this module's output to,
+    //keep the loop free of virtual calls so that the compiler can optimise it
+    void processBlock(float* buffer, int startSample, int numSamples) override
+    {
+        float phase = m_phase;
+        
+        for (int i = startSample; i < startSample + numSamples; i++)
+        {
+            const float alteredPhase = phase > m_pulseLen ? 0.f : phase / m_pulseLen;
+            buffer[i] += std::sin(alteredPhase * juce::MathConstants<float>::twoPi) * m_gain;
+            buffer[i] += std::sin((alteredPhase + m_phaseOffset) * juce::MathConstants<float>::twoPi) * m_gain;
+            
+            //increment and wrap
+            phase += m_phaseInc;
+            if (phase >= 1.f)
+                phase -= 1.f;
+        }
         
-        //increment and wrap
-        m_phase += m_phaseInc;
-        if (m_phase >= 1.f)
-            m_phase -= 1.f;
+        m_phase = phase;
     }
     
     juce::String getName() override
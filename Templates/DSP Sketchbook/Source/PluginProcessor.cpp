@@ -66,7 +66,7 @@ bool DSPSketchbookAudioProcessor::isMidiEffect() const
 
 double DSPSketchbookAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return audioEngine.getTailLengthSeconds();
 }
 
 int DSPSketchbookAudioProcessor::getNumPrograms()
@@ -96,7 +96,9 @@ void DSPSketchbookAudioProcessor::changeProgramName (int index, const juce::Stri
 //==============================================================================
 void DSPSketchbookAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    //for live use, audioEngine.setPipelinedEffects (true) trades a block of latency for more voices
     audioEngine.prepare (sampleRate, samplesPerBlock);
+    setLatencySamples (juce::roundToInt (audioEngine.getLatencyInSamples()));
     context.midiMessageCollector.reset (sampleRate);
 }
 
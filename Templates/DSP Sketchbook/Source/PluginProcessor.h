@@ -53,7 +53,7 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    sketchbook::AudioEngine<sketchbook::ModuleList<SimpleOsc>, sketchbook::ModuleList<Convolution/*, Delay<float>, Distortion*/>> audioEngine;
+    sketchbook::AudioEngine<sketchbook::ModuleList<SimpleOsc>, sketchbook::ModuleList<Convolution/*, Delay<float>, sketchbook::Oversampled<Distortion, 4>*/>> audioEngine;
     
 private:
     //==============================================================================